@@ -0,0 +1,274 @@
+/*
+bench_trie.c
+
+Dani Sprague
+February 2021
+https://github.com/DaniSprague/C-Word-Trie
+
+Benchmarks for the trie.c Trie implementation.
+
+
+MIT License
+
+Copyright (c) 2021 Dani Sprague
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "trie.h"
+
+#define BENCH_CHURN_ROUNDS 4 // Rounds of adds and deletes before compacting
+#define BENCH_LOOKUPS 2000000 // The number of lookups timed per run
+#define BENCH_WORDS 200000 // The number of words in the benchmark trie
+#define MAX_WORD_LEN 12 // The longest random word generated
+
+/*
+ * next_random
+ * 
+ * A small xorshift generator, so runs are repeatable.
+ * 
+ * state: The generator state, updated in place.
+ * 
+ * returns: The next random number.
+ */
+unsigned long long next_random(unsigned long long* state) {
+	*state ^= *state << 13;
+	*state ^= *state >> 7;
+	*state ^= *state << 17;
+	return *state;
+}
+
+/*
+ * random_word
+ * 
+ * Fills a buffer with a random lowercase word of 3 to MAX_WORD_LEN letters.
+ * 
+ * word: A buffer of at least MAX_WORD_LEN + 1 characters.
+ * state: The generator state.
+ * 
+ * returns: none
+ */
+void random_word(char* word, unsigned long long* state) {
+	int len = 3 + next_random(state) % (MAX_WORD_LEN - 2);
+	for (int i = 0; i < len; i++) {
+		word[i] = 'a' + next_random(state) % 26;
+	}
+	word[len] = '\0';
+}
+
+/*
+ * near_miss
+ * 
+ * Fills a buffer with a word that is not in the trie but shares all but its
+ * last letter with one that is, so looking it up descends the whole word.
+ * 
+ * query: A buffer of at least MAX_WORD_LEN + 1 characters.
+ * trie: The trie the word must be missing from.
+ * words: The words in the trie.
+ * state: The generator state.
+ * 
+ * returns: none
+ */
+void near_miss(char* query, Trie* trie, char (*words)[MAX_WORD_LEN + 1], 
+				unsigned long long* state) {
+	size_t len;
+	do {
+		sprintf(query, "%s", words[next_random(state) % BENCH_WORDS]);
+		len = strlen(query);
+		query[len - 1] = 'a' + next_random(state) % 26;
+	} while (check_trie(trie, query));
+}
+
+/*
+ * elapsed_ns
+ * 
+ * Gets the time between two points in nanoseconds.
+ * 
+ * start: The earlier time.
+ * end: The later time.
+ * 
+ * returns: The nanoseconds between start and end.
+ */
+double elapsed_ns(struct timespec* start, struct timespec* end) {
+	return (end -> tv_sec - start -> tv_sec) * 1e9 + 
+			(end -> tv_nsec - start -> tv_nsec);
+}
+
+/*
+ * time_lookups
+ * 
+ * Times check_trie() over a list of queries.
+ * 
+ * trie: The trie to look words up in.
+ * queries: The words to look up.
+ * num_queries: The number of words in queries.
+ * 
+ * returns: The mean nanoseconds per lookup.
+ */
+double time_lookups(Trie* trie, char (*queries)[MAX_WORD_LEN + 1], 
+					int num_queries) {
+	struct timespec start;
+	struct timespec end;
+	volatile int found = 0;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int i = 0; i < num_queries; i++) {
+		found += check_trie(trie, queries[i]);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return elapsed_ns(&start, &end) / num_queries;
+}
+
+/*
+ * bench_filter
+ * 
+ * Compares lookup latency with and without a filter at several miss ratios,
+ * for random misses, which leave the trie within a few levels, and for near
+ * misses, which descend the whole word first.
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int bench_filter() {
+	int miss_percents[] = {0, 50, 90, 99};
+	char (*words)[MAX_WORD_LEN + 1] = malloc(BENCH_WORDS * sizeof(*words));
+	char (*queries)[MAX_WORD_LEN + 1] = malloc(BENCH_LOOKUPS * sizeof(*queries));
+	unsigned long long state = 88172645463325252ULL;
+	Trie* trie = create_trie();
+	double plain;
+	double filtered;
+	if (words == NULL || queries == NULL || trie == NULL) {
+		free(words);
+		free(queries);
+		free(trie);
+		return 1;
+	}
+	for (int i = 0; i < BENCH_WORDS; i++) {
+		random_word(words[i], &state);
+		add_to_trie(trie, words[i]);
+	}
+	printf("Filter: %d words, %d lookups per run\n", BENCH_WORDS, 
+			BENCH_LOOKUPS);
+	printf("%8s %8s %14s %14s\n", "misses", "miss %", "plain ns/op", 
+			"filtered ns/op");
+	for (int near = 0; near < 2; near++) {
+		for (int m = 0; m < sizeof(miss_percents) / sizeof(int); m++) {
+			for (int i = 0; i < BENCH_LOOKUPS; i++) {
+				if (next_random(&state) % 100 >= miss_percents[m]) {
+					sprintf(queries[i], "%s", 
+							words[next_random(&state) % BENCH_WORDS]);
+				} else if (near) {
+					near_miss(queries[i], trie, words, &state);
+				} else {
+					do {
+						random_word(queries[i], &state);
+					} while (check_trie(trie, queries[i]));
+				}
+			}
+			disable_trie_filter(trie);
+			plain = time_lookups(trie, queries, BENCH_LOOKUPS);
+			enable_trie_filter(trie, BENCH_WORDS);
+			filtered = time_lookups(trie, queries, BENCH_LOOKUPS);
+			printf("%8s %8d %14.1f %14.1f\n", near ? "near" : "random", 
+					miss_percents[m], plain, filtered);
+		}
+	}
+	disable_trie_filter(trie);
+	clear_trie(trie);
+	free(trie);
+	free(words);
+	free(queries);
+	return 0;
+}
+
+/*
+ * bench_compact
+ * 
+ * Compares lookup latency on a trie churned by adds and deletes before and
+ * after compacting it.
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int bench_compact() {
+	char (*words)[MAX_WORD_LEN + 1] = malloc(BENCH_WORDS * sizeof(*words));
+	char (*queries)[MAX_WORD_LEN + 1] = malloc(BENCH_LOOKUPS * sizeof(*queries));
+	char churn[MAX_WORD_LEN + 1];
+	unsigned long long state = 2463534242ULL;
+	Trie* trie = create_trie();
+	double fresh;
+	double churned;
+	double compacted;
+	int moved;
+	if (words == NULL || queries == NULL || trie == NULL) {
+		free(words);
+		free(queries);
+		free(trie);
+		return 1;
+	}
+	for (int i = 0; i < BENCH_WORDS; i++) {
+		random_word(words[i], &state);
+		add_to_trie(trie, words[i]);
+	}
+	for (int i = 0; i < BENCH_LOOKUPS; i++) {
+		sprintf(queries[i], "%s", words[next_random(&state) % BENCH_WORDS]);
+	}
+	fresh = time_lookups(trie, queries, BENCH_LOOKUPS);
+	for (int round = 0; round < BENCH_CHURN_ROUNDS; round++) {
+		for (int i = 0; i < BENCH_WORDS; i++) { // Replace half the words
+			if (next_random(&state) % 2 == 0) {
+				delete_from_trie(trie, words[i]);
+				random_word(churn, &state);
+				add_to_trie(trie, churn);
+				add_to_trie(trie, words[i]);
+			}
+		}
+	}
+	churned = time_lookups(trie, queries, BENCH_LOOKUPS);
+	moved = compact_trie(trie);
+	compacted = time_lookups(trie, queries, BENCH_LOOKUPS);
+	printf("\nCompaction: %d words, %d churn rounds, %d nodes moved\n",
+			BENCH_WORDS, BENCH_CHURN_ROUNDS, moved);
+	printf("%14s %14s %14s\n", "fresh ns/op", "churned ns/op", 
+			"compact ns/op");
+	printf("%14.1f %14.1f %14.1f\n", fresh, churned, compacted);
+	clear_trie(trie);
+	free(trie);
+	free(words);
+	free(queries);
+	return moved < 0 ? 1 : 0;
+}
+
+/*
+ * main
+ * 
+ * Runs all benchmarks.
+ * 
+ * returns: 0 upon success, 1 otherwise.
+ */
+int main() {
+	int count = 0;
+	int (*benches[])() = {&bench_filter, &bench_compact, NULL};
+
+	for (int i = 0; benches[i] != NULL; i++) {
+		count += benches[i]();
+	}
+	return count >= 1 ? 1 : 0;
+}
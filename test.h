@@ -60,6 +60,17 @@ int assert_false(bool condition, char* name);
  */ 
 int assert_true(bool condition, char* name);
 
+/*
+ * failing_fsync
+ * 
+ * Stands in for fsync() in the log, failing while failing_syncs is positive.
+ * 
+ * fd: The file descriptor to sync.
+ * 
+ * returns: 0 upon success, -1 upon error or an injected failure.
+ */
+int failing_fsync(int fd);
+
 /*
  * free_mem
  * 
@@ -67,6 +78,15 @@ int assert_true(bool condition, char* name);
  */
 void free_mem(Trie* head);
 
+/*
+ * remove_log_files
+ * 
+ * Removes the log files made by a test and their directory.
+ * 
+ * dir: The directory holding the files named "words".
+ */
+void remove_log_files(char* dir);
+
 /*
  * run_test
  * 
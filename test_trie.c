@@ -31,11 +31,19 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#define _POSIX_C_SOURCE 200809L // For mkdtemp and fsync
+
+#include <errno.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 #include "test.h"
 #include "trie.h"
+#include "trie_log.h"
+
+int failing_syncs = 0; // The number of coming fsync() calls to fail
 
 /*
  * test_add_error_check
@@ -265,6 +273,108 @@ int test_clear_single() {
 	return test;
 }
 
+/*
+ * test_compact
+ * 
+ * Verifies that compact_trie() keeps every word and word count.
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int test_compact() {
+	int test;
+	char buffer[8];
+	Trie* trie = create_trie();
+	add_to_trie(trie, "apple");
+	add_to_trie(trie, "apples");
+	add_to_trie(trie, "banana");
+	add_to_trie(trie, "oobleck");
+	delete_from_trie(trie, "banana");
+	test = assert_true(compact_trie(trie) == 13 &&
+						check_trie(trie, "apple") == 1 &&
+						check_trie(trie, "apples") == 1 &&
+						check_trie(trie, "banana") == 0 &&
+						check_trie(trie, "oobleck") == 1 &&
+						rank_in_trie(trie, "oobleck") == 2 &&
+						select_from_trie(trie, 1, buffer, 8) == 6 &&
+						strcmp(buffer, "apples") == 0,
+						"Compacted trie keeps its words");
+	free_mem(trie);
+	return test;
+}
+
+/*
+ * test_compact_churn
+ * 
+ * Verifies that a compacted trie can be changed, compacted again, merged and
+ * cleared.
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int test_compact_churn() {
+	int test;
+	bool cond;
+	Trie* trie = create_trie();
+	Trie* src = create_trie();
+	add_to_trie(trie, "apple");
+	add_to_trie(trie, "banana");
+	add_to_trie(src, "apples");
+	add_to_trie(src, "cherry");
+	compact_trie(trie);
+	compact_trie(src);
+	delete_from_trie(trie, "banana");
+	add_to_trie(trie, "bananas");
+	cond = compact_trie(trie) == 12 && union_tries(trie, src) == 4;
+	delete_prefix_from_trie(trie, "ch");
+	cond = cond && compact_trie(trie) == 13 && compact_trie(src) == 0;
+	test = assert_true(cond && check_trie(trie, "apple") == 1 &&
+						check_trie(trie, "apples") == 1 &&
+						check_trie(trie, "banana") == 0 &&
+						check_trie(trie, "bananas") == 1 &&
+						check_trie(trie, "cherry") == 0,
+						"Compacted trie changed and compacted again");
+	free_mem(trie);
+	free_mem(src);
+	return test;
+}
+
+/*
+ * test_compact_large
+ * 
+ * Verifies that a trie too big for one arena is compacted, and that freeing
+ * its nodes a few at a time and all at once both release the arenas.
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int test_compact_large() {
+	int test;
+	bool found = true;
+	char word[6] = {0};
+	Trie* trie = create_trie();
+	for (int i = 0; i < 20000; i++) {
+		for (int j = 0, n = i * 7; j < 5; j++, n /= 26) {
+			word[j] = 'a' + n % 26;
+		}
+		add_to_trie(trie, word);
+	}
+	test = compact_trie(trie) > 20000 ? 0 : 1;
+	for (int i = 0; i < 20000; i++) {
+		for (int j = 0, n = i * 7; j < 5; j++, n /= 26) {
+			word[j] = 'a' + n % 26;
+		}
+		found = found && check_trie(trie, word) == 1;
+		if (i % 2 == 0) {
+			delete_from_trie(trie, word);
+		}
+	}
+	reclaim_trie_nodes(trie, 0);
+	test = assert_true(!test && found && 
+						rank_in_trie(trie, "zzzzzz") == 10000 &&
+						compact_trie(trie) > 0,
+						"Trie compacted across several arenas");
+	free_mem(trie);
+	return test;
+}
+
 /*
  * test_create
  * 
@@ -312,6 +422,176 @@ int test_delete_substring() {
 	return assert_true(cond, "Only substring deleted from trie");
 }
 
+/*
+ * test_delete_superstring
+ * 
+ * Verifies that delete_from_trie() leaves a substring intact when deleting
+ * the superstring, and that the superstring can be added again.
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int test_delete_superstring() {
+	struct node* trie = create_trie();
+	bool cond;
+	add_to_trie(trie, "apples");
+	add_to_trie(trie, "apple");
+	delete_from_trie(trie, "apples");
+	cond = check_trie(trie, "apples") == 0 && check_trie(trie, "apple") == 1 &&
+			add_to_trie(trie, "apples") == 1 && check_trie(trie, "apples") == 1;
+	free_mem(trie);
+	return assert_true(cond, "Only superstring deleted from trie");
+}
+
+/*
+ * test_delete_prefix
+ * 
+ * Verifies that delete_prefix_from_trie() removes only words under a prefix.
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int test_delete_prefix() {
+	struct node* trie = create_trie();
+	bool cond;
+	add_to_trie(trie, "app");
+	add_to_trie(trie, "apple");
+	add_to_trie(trie, "apples");
+	add_to_trie(trie, "apply");
+	add_to_trie(trie, "ap");
+	add_to_trie(trie, "banana");
+	cond = delete_prefix_from_trie(trie, "app") == 4 && 
+			check_trie(trie, "app") == 0 && check_trie(trie, "apple") == 0 &&
+			check_trie(trie, "apply") == 0 && check_trie(trie, "ap") == 1 &&
+			check_trie(trie, "banana") == 1;
+	free_mem(trie);
+	return assert_true(cond, "Words under prefix deleted from trie");
+}
+
+/*
+ * test_delete_prefix_all
+ * 
+ * Verifies that delete_prefix_from_trie() with an empty prefix deletes every
+ * word, and that words can be added again afterwards.
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int test_delete_prefix_all() {
+	struct node* trie = create_trie();
+	bool cond;
+	add_to_trie(trie, "apples");
+	add_to_trie(trie, "bananas");
+	add_to_trie(trie, "oobleck");
+	cond = delete_prefix_from_trie(trie, "") == 3 &&
+			check_trie(trie, "apples") == 0 && check_trie(trie, "oobleck") == 0;
+	add_to_trie(trie, "banana");
+	cond = cond && check_trie(trie, "banana") == 1 && 
+			check_trie(trie, "bananas") == 0;
+	free_mem(trie);
+	return assert_true(cond, "Empty prefix deleted all words from trie");
+}
+
+/*
+ * test_delete_prefix_missing
+ * 
+ * Verifies that delete_prefix_from_trie() handles prefixes not in the trie.
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int test_delete_prefix_missing() {
+	struct node* trie = create_trie();
+	bool cond;
+	add_to_trie(trie, "apples");
+	cond = delete_prefix_from_trie(trie, "b") == 0 &&
+			delete_prefix_from_trie(trie, "applesauce") == 0 &&
+			delete_prefix_from_trie(trie, "APP") == 0 &&
+			check_trie(trie, "apples") == 1;
+	free_mem(trie);
+	return assert_true(cond, "Deleting missing prefix handled");
+}
+
+/*
+ * test_rank
+ * 
+ * Verifies that rank_in_trie() counts the words sorting before a word.
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int test_rank() {
+	int test;
+	Trie* trie = create_trie();
+	add_to_trie(trie, "apple");
+	add_to_trie(trie, "apples");
+	add_to_trie(trie, "banana");
+	add_to_trie(trie, "oobleck");
+	add_to_trie(trie, "");
+	test = assert_true(rank_in_trie(trie, "") == 0 &&
+						rank_in_trie(trie, "apple") == 1 &&
+						rank_in_trie(trie, "apples") == 2 &&
+						rank_in_trie(trie, "applesauce") == 3 &&
+						rank_in_trie(trie, "b") == 3 &&
+						rank_in_trie(trie, "oobleck") == 4 &&
+						rank_in_trie(trie, "zebra") == 5 &&
+						rank_in_trie(trie, "Zebra") == -2, 
+						"Ranks of words in trie");
+	free_mem(trie);
+	return test;
+}
+
+/*
+ * test_select
+ * 
+ * Verifies that select_from_trie() finds words by sorted position, including
+ * after deletes.
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int test_select() {
+	int test;
+	char buffer[8];
+	bool cond;
+	Trie* trie = create_trie();
+	add_to_trie(trie, "oobleck");
+	add_to_trie(trie, "apples");
+	add_to_trie(trie, "apple");
+	add_to_trie(trie, "banana");
+	add_to_trie(trie, "bananas");
+	delete_from_trie(trie, "bananas");
+	cond = select_from_trie(trie, 0, buffer, 8) == 5 && 
+			strcmp(buffer, "apple") == 0;
+	cond = cond && select_from_trie(trie, 1, buffer, 8) == 6 && 
+			strcmp(buffer, "apples") == 0;
+	cond = cond && select_from_trie(trie, 2, buffer, 8) == 6 && 
+			strcmp(buffer, "banana") == 0;
+	cond = cond && select_from_trie(trie, 3, buffer, 8) == 7 && 
+			strcmp(buffer, "oobleck") == 0;
+	test = assert_true(cond && select_from_trie(trie, 4, buffer, 8) == -1 &&
+						select_from_trie(trie, -1, buffer, 8) == -1 &&
+						select_from_trie(trie, 3, buffer, 7) == -2,
+						"Words selected by position in trie");
+	free_mem(trie);
+	return test;
+}
+
+/*
+ * test_reclaim_nodes
+ * 
+ * Verifies that reclaim_trie_nodes() frees the nodes of a deleted prefix.
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int test_reclaim_nodes() {
+	struct node* trie = create_trie();
+	bool cond;
+	add_to_trie(trie, "abc");
+	add_to_trie(trie, "abd");
+	add_to_trie(trie, "x");
+	delete_prefix_from_trie(trie, "a");
+	cond = reclaim_trie_nodes(trie, 1) == 1 && 
+			reclaim_trie_nodes(trie, 0) == 3 && 
+			reclaim_trie_nodes(trie, 0) == 0 && check_trie(trie, "x") == 1;
+	free_mem(trie);
+	return assert_true(cond, "Deleted prefix nodes reclaimed");
+}
+
 /*
  * test_delete_valid
  * 
@@ -346,6 +626,707 @@ int test_delete_valid_ret() {
 	return assert_true(cond, "Word in trie deleted from trie returned good");
 }
 
+/*
+ * test_load_words
+ * 
+ * Verifies that load_trie() adds, normalizes and rejects words from a stream.
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int test_load_words() {
+	int test;
+	struct load_stats stats;
+	Trie* trie = create_trie();
+	FILE* stream = tmpfile();
+	fputs("apples\nBananas  oobleck\r\n\tapples don't 42\nlast", stream);
+	rewind(stream);
+	test = assert_true(load_trie(trie, stream, &stats) == 0 &&
+						stats.words_read == 7 && stats.words_added == 4 &&
+						stats.words_rejected == 2 && stats.bytes_read == 46 &&
+						check_trie(trie, "apples") == 1 &&
+						check_trie(trie, "bananas") == 1 &&
+						check_trie(trie, "oobleck") == 1 &&
+						check_trie(trie, "last") == 1,
+						"Words loaded from stream");
+	fclose(stream);
+	free_mem(trie);
+	return test;
+}
+
+/*
+ * test_load_long_word
+ * 
+ * Verifies that load_trie() rejects words too long to add, whether they fit
+ * in one read block or span several.
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int test_load_long_word() {
+	int test = 0;
+	struct load_stats stats;
+	size_t lens[] = {4096, 4097, 900000, 3000000, 0};
+	Trie* trie = create_trie();
+	FILE* stream;
+	for (int i = 0; lens[i] != 0; i++) {
+		stream = tmpfile();
+		fputs("apple ", stream);
+		for (size_t j = 0; j < lens[i]; j++) {
+			fputc('a', stream);
+		}
+		fputs(" pear", stream);
+		rewind(stream);
+		clear_trie(trie);
+		test = test || load_trie(trie, stream, &stats) != 0 ||
+				stats.words_read != 3 || 
+				stats.words_rejected != (lens[i] > 4096 ? 1 : 0) ||
+				check_trie(trie, "pear") != 1;
+		fclose(stream);
+	}
+	test = assert_true(!test, "Over-long words rejected from stream");
+	free_mem(trie);
+	return test;
+}
+
+/*
+ * test_load_large
+ * 
+ * Verifies that load_trie() handles words split across read blocks.
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int test_load_large() {
+	int test;
+	struct load_stats stats;
+	char word[6] = {0};
+	bool found = true;
+	Trie* trie = create_trie();
+	FILE* stream = tmpfile();
+	for (int i = 0; i < 300000; i++) {
+		for (int j = 0, n = i; j < 5; j++, n /= 26) {
+			word[4 - j] = 'a' + n % 26;
+		}
+		fprintf(stream, "%s\n", word);
+	}
+	rewind(stream);
+	test = load_trie(trie, stream, &stats);
+	for (int i = 0; i < 300000 && found; i += 997) {
+		for (int j = 0, n = i; j < 5; j++, n /= 26) {
+			word[4 - j] = 'a' + n % 26;
+		}
+		found = check_trie(trie, word) == 1;
+	}
+	test = assert_true(test == 0 && stats.words_added == 300000 &&
+						stats.words_rejected == 0 && found,
+						"Large stream loaded");
+	fclose(stream);
+	free_mem(trie);
+	return test;
+}
+
+/*
+ * test_log_checkpoint
+ * 
+ * Verifies that a trie is recovered from a checkpoint plus the changes logged
+ * after it, including the empty word.
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int test_log_checkpoint() {
+	int test;
+	char dir[] = "/tmp/test_trieXXXXXX";
+	char path[64];
+	TrieLog* log;
+	Trie* trie = create_trie();
+	Trie* recovered = create_trie();
+	mkdtemp(dir);
+	snprintf(path, sizeof(path), "%s/words", dir);
+	log = open_trie_log(trie, path, 1, 0);
+	log_add_to_trie(log, "apple");
+	log_add_to_trie(log, "apples");
+	log_add_to_trie(log, "");
+	checkpoint_trie_log(log);
+	log_delete_from_trie(log, "apple");
+	log_add_to_trie(log, "banana");
+	close_trie_log(log);
+	log = open_trie_log(recovered, path, 1, 0);
+	test = assert_true(log != NULL && check_trie(recovered, "apple") == 0 &&
+						check_trie(recovered, "apples") == 1 &&
+						check_trie(recovered, "banana") == 1 &&
+						check_trie(recovered, "") == 1,
+						"Trie recovered from checkpoint and log");
+	close_trie_log(log);
+	remove_log_files(dir);
+	free_mem(trie);
+	free_mem(recovered);
+	return test;
+}
+
+/*
+ * test_log_corrupt
+ * 
+ * Verifies that recovery fails on a bad change before the end of the log,
+ * rather than dropping the changes after it.
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int test_log_corrupt() {
+	int test;
+	char dir[] = "/tmp/test_trieXXXXXX";
+	char path[64];
+	char* logs[] = {"+apples\n+Ban4na\n+oobleck\n", "+apples\n-B\n",
+					"+apples\n*\n+banan", NULL};
+	FILE* file;
+	TrieLog* log = NULL;
+	Trie* trie = create_trie();
+	mkdtemp(dir);
+	for (int i = 0; logs[i] != NULL && log == NULL; i++) {
+		snprintf(path, sizeof(path), "%s/words.log", dir);
+		file = fopen(path, "w");
+		fputs(logs[i], file);
+		fclose(file);
+		snprintf(path, sizeof(path), "%s/words", dir);
+		clear_trie(trie);
+		log = open_trie_log(trie, path, 1, 0);
+	}
+	test = assert_true(log == NULL, "Recovery fails on a bad change");
+	close_trie_log(log);
+	remove_log_files(dir);
+	free_mem(trie);
+	return test;
+}
+
+/*
+ * test_log_recover
+ * 
+ * Verifies that a trie is recovered by replaying its log.
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int test_log_recover() {
+	int test;
+	char dir[] = "/tmp/test_trieXXXXXX";
+	char path[64];
+	TrieLog* log;
+	Trie* trie = create_trie();
+	Trie* recovered = create_trie();
+	mkdtemp(dir);
+	snprintf(path, sizeof(path), "%s/words", dir);
+	log = open_trie_log(trie, path, 2, 0);
+	test = log_add_to_trie(log, "apples") != 1 || 
+			log_add_to_trie(log, "apples") != 0 ||
+			log_add_to_trie(log, "Apples") != -2 ||
+			log_add_to_trie(log, "bananas") != 1 ||
+			log_delete_from_trie(log, "apples") != 1 ||
+			log_delete_from_trie(log, "oobleck") != 0;
+	close_trie_log(log);
+	log = open_trie_log(recovered, path, 2, 0);
+	test = assert_true(!test && log != NULL && 
+						check_trie(recovered, "apples") == 0 &&
+						check_trie(recovered, "bananas") == 1,
+						"Trie recovered from log");
+	close_trie_log(log);
+	remove_log_files(dir);
+	free_mem(trie);
+	free_mem(recovered);
+	return test;
+}
+
+/*
+ * test_log_sync_failure
+ * 
+ * Verifies that a failed sync rolls back every change made since the last
+ * sync, in both the trie and the log, and that the log can still be used.
+ * Also verifies that a new log is not opened if its directory can't be
+ * synced.
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int test_log_sync_failure() {
+	int test;
+	char dir[] = "/tmp/test_trieXXXXXX";
+	char path[64];
+	TrieLog* log;
+	Trie* trie = create_trie();
+	Trie* recovered = create_trie();
+	mkdtemp(dir);
+	snprintf(path, sizeof(path), "%s/words", dir);
+	trie_log_fsync = &failing_fsync;
+	failing_syncs = 1;
+	test = open_trie_log(trie, path, 3, 0) != NULL;
+	snprintf(path, sizeof(path), "%s/words.log", dir);
+	remove(path);
+	snprintf(path, sizeof(path), "%s/words", dir);
+	log = open_trie_log(trie, path, 3, 0);
+	log_add_to_trie(log, "apple");
+	sync_trie_log(log);
+	log_delete_from_trie(log, "apple");
+	log_add_to_trie(log, "banana");
+	failing_syncs = 1;
+	test = test || log_add_to_trie(log, "ghost") != -1 || 
+			check_trie(trie, "apple") != 1 ||
+			check_trie(trie, "banana") != 0 ||
+			check_trie(trie, "ghost") != 0;
+	test = test || log_add_to_trie(log, "cherry") != 1;
+	close_trie_log(log);
+	log = open_trie_log(recovered, path, 3, 0);
+	test = assert_true(!test && log != NULL && 
+						check_trie(recovered, "apple") == 1 &&
+						check_trie(recovered, "banana") == 0 &&
+						check_trie(recovered, "ghost") == 0 &&
+						check_trie(recovered, "cherry") == 1,
+						"Group rolled back on sync failure");
+	close_trie_log(log);
+	trie_log_fsync = &fsync;
+	remove_log_files(dir);
+	free_mem(trie);
+	free_mem(recovered);
+	return test;
+}
+
+/*
+ * test_log_torn_write
+ * 
+ * Verifies that recovery skips a change cut off mid-write and that changes
+ * logged afterwards are still recovered.
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int test_log_torn_write() {
+	int test;
+	char dir[] = "/tmp/test_trieXXXXXX";
+	char path[64];
+	FILE* file;
+	TrieLog* log;
+	Trie* trie = create_trie();
+	Trie* recovered = create_trie();
+	mkdtemp(dir);
+	snprintf(path, sizeof(path), "%s/words.log", dir);
+	file = fopen(path, "w");
+	fputs("+apples\n+banan", file);
+	fclose(file);
+	snprintf(path, sizeof(path), "%s/words", dir);
+	log = open_trie_log(trie, path, 1, 3);
+	log_add_to_trie(log, "oobleck");
+	close_trie_log(log);
+	log = open_trie_log(recovered, path, 1, 3);
+	test = assert_true(log != NULL && check_trie(recovered, "apples") == 1 &&
+						check_trie(recovered, "banan") == 0 &&
+						check_trie(recovered, "bananoobleck") == 0 &&
+						check_trie(recovered, "oobleck") == 1,
+						"Trie recovered past torn write");
+	close_trie_log(log);
+	remove_log_files(dir);
+	free_mem(trie);
+	free_mem(recovered);
+	return test;
+}
+
+/*
+ * test_longest_prefix_match
+ * 
+ * Verifies that longest_prefix_in_trie() finds the longest stored prefix.
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int test_longest_prefix_match() {
+	int test;
+	Trie* trie = create_trie();
+	add_to_trie(trie, "app");
+	add_to_trie(trie, "apple");
+	add_to_trie(trie, "applesauce");
+	test = assert_true(longest_prefix_in_trie(trie, "applesau", 8) == 5,
+						"Longest prefix of \"applesau\" is \"apple\"");
+	free_mem(trie);
+	return test;
+}
+
+/*
+ * test_longest_prefix_no_match
+ * 
+ * Verifies that longest_prefix_in_trie() returns 0 when no word matches.
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int test_longest_prefix_no_match() {
+	int test;
+	Trie* trie = create_trie();
+	add_to_trie(trie, "apple");
+	test = assert_true(longest_prefix_in_trie(trie, "appl", 4) == 0 &&
+						longest_prefix_in_trie(trie, "Apple", 5) == 0,
+						"No prefix matched in trie");
+	free_mem(trie);
+	return test;
+}
+
+/*
+ * test_longest_prefix_unterminated
+ * 
+ * Verifies that longest_prefix_in_trie() does not read past len.
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int test_longest_prefix_unterminated() {
+	int test;
+	char text[] = {'a', 'p', 'p', 'l', 'e'};
+	Trie* trie = create_trie();
+	add_to_trie(trie, "app");
+	add_to_trie(trie, "apple");
+	test = assert_true(longest_prefix_in_trie(trie, text, 4) == 3,
+						"Prefix match limited to len characters");
+	free_mem(trie);
+	return test;
+}
+
+/*
+ * test_reclaim_nodes_per_trie
+ * 
+ * Verifies that the nodes detached from one trie are not reclaimed or reused
+ * by another.
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int test_reclaim_nodes_per_trie() {
+	struct node* trie = create_trie();
+	struct node* other = create_trie();
+	bool cond;
+	add_to_trie(trie, "abc");
+	delete_prefix_from_trie(trie, "a");
+	add_to_trie(other, "xyz");
+	cond = reclaim_trie_nodes(other, 0) == 0 && 
+			reclaim_trie_nodes(trie, 0) == 3;
+	free_mem(trie);
+	free_mem(other);
+	return assert_true(cond, "Detached nodes kept per trie");
+}
+
+/*
+ * test_segment_greedy
+ * 
+ * Verifies that segment_greedy_with_trie() splits text into longest words.
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int test_segment_greedy() {
+	int test;
+	size_t bounds[4];
+	int ret;
+	Trie* trie = create_trie();
+	add_to_trie(trie, "pen");
+	add_to_trie(trie, "pine");
+	add_to_trie(trie, "apple");
+	ret = segment_greedy_with_trie(trie, "pineapplepen", 12, bounds, 4);
+	test = assert_true(ret == 3 && bounds[0] == 4 && bounds[1] == 9 &&
+						bounds[2] == 12, "Greedy segmentation of \"pineapplepen\"");
+	free_mem(trie);
+	return test;
+}
+
+/*
+ * test_segment_greedy_fail
+ * 
+ * Verifies that segment_greedy_with_trie() reports text it cannot split.
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int test_segment_greedy_fail() {
+	int test;
+	size_t bounds[4];
+	Trie* trie = create_trie();
+	add_to_trie(trie, "a");
+	add_to_trie(trie, "ab");
+	add_to_trie(trie, "bc");
+	test = assert_true(segment_greedy_with_trie(trie, "abc", 3, bounds, 4) == -1,
+						"Greedy segmentation of \"abc\" fails");
+	free_mem(trie);
+	return test;
+}
+
+/*
+ * test_segment_optimal
+ * 
+ * Verifies that segment_optimal_with_trie() finds a split greedy misses.
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int test_segment_optimal() {
+	int test;
+	size_t bounds[4];
+	int ret;
+	Trie* trie = create_trie();
+	add_to_trie(trie, "a");
+	add_to_trie(trie, "ab");
+	add_to_trie(trie, "bc");
+	ret = segment_optimal_with_trie(trie, "abc", 3, bounds, 4);
+	test = assert_true(ret == 2 && bounds[0] == 1 && bounds[1] == 3,
+						"Optimal segmentation of \"abc\"");
+	free_mem(trie);
+	return test;
+}
+
+/*
+ * test_segment_optimal_fewest
+ * 
+ * Verifies that segment_optimal_with_trie() prefers fewer words and reports a
+ * bounds array that is too small.
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int test_segment_optimal_fewest() {
+	int test;
+	size_t bounds[2];
+	int ret;
+	Trie* trie = create_trie();
+	add_to_trie(trie, "a");
+	add_to_trie(trie, "b");
+	add_to_trie(trie, "ab");
+	ret = segment_optimal_with_trie(trie, "abab", 4, bounds, 2);
+	test = assert_true(ret == 2 && bounds[0] == 2 && bounds[1] == 4 &&
+						segment_optimal_with_trie(trie, "abab", 4, bounds, 1)
+						== -2, "Optimal segmentation uses fewest words");
+	free_mem(trie);
+	return test;
+}
+
+/*
+ * test_difference_tries
+ * 
+ * Verifies that difference_tries() removes only the words in the other trie.
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int test_difference_tries() {
+	int test;
+	Trie* trie = create_trie();
+	Trie* other = create_trie();
+	add_to_trie(trie, "apple");
+	add_to_trie(trie, "apples");
+	add_to_trie(trie, "banana");
+	add_to_trie(other, "apples");
+	add_to_trie(other, "banana");
+	add_to_trie(other, "cherry");
+	test = assert_true(difference_tries(trie, other) == 1 &&
+						check_trie(trie, "apple") == 1 &&
+						check_trie(trie, "apples") == 0 &&
+						check_trie(trie, "banana") == 0 &&
+						check_trie(trie, "cherry") == 0 &&
+						check_trie(other, "apples") == 1 &&
+						delete_prefix_from_trie(trie, "") == 1,
+						"Difference of tries");
+	free_mem(trie);
+	free_mem(other);
+	return test;
+}
+
+/*
+ * test_filter_membership
+ * 
+ * Verifies that check_trie() gives the same answers with a filter enabled,
+ * across adds and deletes made before and after enabling it.
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int test_filter_membership() {
+	int test;
+	bool cond;
+	Trie* trie = create_trie();
+	add_to_trie(trie, "apples");
+	add_to_trie(trie, "apple");
+	cond = enable_trie_filter(trie, 16) == 0;
+	add_to_trie(trie, "bananas");
+	add_to_trie(trie, "");
+	delete_from_trie(trie, "apple");
+	cond = cond && check_trie(trie, "apples") == 1 && 
+			check_trie(trie, "bananas") == 1 && check_trie(trie, "") == 1 &&
+			check_trie(trie, "apple") == 0 && check_trie(trie, "banana") == 0 &&
+			check_trie(trie, "oobleck") == 0;
+	clear_trie(trie);
+	add_to_trie(trie, "oobleck");
+	test = assert_true(cond && check_trie(trie, "apples") == 0 &&
+						check_trie(trie, "oobleck") == 1,
+						"Filtered trie membership");
+	disable_trie_filter(trie);
+	free_mem(trie);
+	return test;
+}
+
+/*
+ * test_filter_many
+ * 
+ * Verifies that a filtered trie never rejects a word it holds, including
+ * words loaded from a stream and grafted in by union_tries().
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int test_filter_many() {
+	int test;
+	bool found = true;
+	bool missing = true;
+	char word[5] = {0};
+	Trie* trie = create_trie();
+	Trie* src = create_trie();
+	FILE* stream = tmpfile();
+	for (int i = 0; i < 26 * 26 * 26; i += 2) {
+		fprintf(stream, "%c%c%c\n", 'a' + i % 26, 'a' + i / 26 % 26, 
+				'a' + i / 676);
+	}
+	rewind(stream);
+	enable_trie_filter(trie, 26 * 26 * 26);
+	load_trie(trie, stream, NULL);
+	add_to_trie(src, "zzzz");
+	add_to_trie(src, "ab");
+	union_tries(trie, src);
+	for (int i = 0; i < 26 * 26 * 26; i++) {
+		word[0] = 'a' + i % 26;
+		word[1] = 'a' + i / 26 % 26;
+		word[2] = 'a' + i / 676;
+		if (i % 2 == 0) {
+			found = found && check_trie(trie, word) == 1;
+		} else {
+			missing = missing && check_trie(trie, word) == 0;
+		}
+	}
+	test = assert_true(found && missing && check_trie(trie, "zzzz") == 1 &&
+						check_trie(trie, "ab") == 1,
+						"Filtered trie has no false negatives");
+	fclose(stream);
+	disable_trie_filter(trie);
+	free_mem(trie);
+	free_mem(src);
+	return test;
+}
+
+/*
+ * test_intersect_tries
+ * 
+ * Verifies that intersect_tries() keeps only the words in both tries.
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int test_intersect_tries() {
+	int test;
+	Trie* trie = create_trie();
+	Trie* other = create_trie();
+	add_to_trie(trie, "apple");
+	add_to_trie(trie, "apples");
+	add_to_trie(trie, "banana");
+	add_to_trie(trie, "oobleck");
+	add_to_trie(other, "apples");
+	add_to_trie(other, "banana");
+	add_to_trie(other, "bananas");
+	test = assert_true(intersect_tries(trie, other) == 2 &&
+						check_trie(trie, "apple") == 0 &&
+						check_trie(trie, "apples") == 1 &&
+						check_trie(trie, "banana") == 1 &&
+						check_trie(trie, "bananas") == 0 &&
+						check_trie(trie, "oobleck") == 0 &&
+						delete_prefix_from_trie(trie, "") == 2,
+						"Intersection of tries");
+	free_mem(trie);
+	free_mem(other);
+	return test;
+}
+
+/*
+ * test_set_same_trie
+ * 
+ * Verifies that set operations reject the same trie on both sides.
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int test_set_same_trie() {
+	int test;
+	Trie* trie = create_trie();
+	add_to_trie(trie, "apples");
+	test = assert_true(union_tries(trie, trie) == -1 &&
+						intersect_tries(trie, trie) == -1 &&
+						difference_tries(trie, trie) == -1 &&
+						check_trie(trie, "apples") == 1,
+						"Set operations on the same trie rejected");
+	free_mem(trie);
+	return test;
+}
+
+/*
+ * test_union_tries
+ * 
+ * Verifies that union_tries() moves all words into dest and empties src.
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int test_union_tries() {
+	int test;
+	Trie* trie = create_trie();
+	Trie* src = create_trie();
+	add_to_trie(trie, "apple");
+	add_to_trie(trie, "banana");
+	add_to_trie(src, "apples");
+	add_to_trie(src, "banana");
+	add_to_trie(src, "cherry");
+	test = assert_true(union_tries(trie, src) == 4 &&
+						check_trie(trie, "apple") == 1 &&
+						check_trie(trie, "apples") == 1 &&
+						check_trie(trie, "banana") == 1 &&
+						check_trie(trie, "cherry") == 1 &&
+						check_trie(src, "cherry") == 0 &&
+						delete_from_trie(trie, "apples") == 1 &&
+						check_trie(trie, "apple") == 1 &&
+						delete_prefix_from_trie(trie, "") == 3,
+						"Union of tries");
+	free_mem(trie);
+	free_mem(src);
+	return test;
+}
+
+/*
+ * test_write_source
+ * 
+ * Verifies that write_trie_source() writes out every node and the lookup
+ * function.
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int test_write_source() {
+	int test;
+	int ret;
+	char source[4096] = {0};
+	Trie* trie = create_trie();
+	FILE* stream = tmpfile();
+	add_to_trie(trie, "ab");
+	add_to_trie(trie, "b");
+	ret = write_trie_source(trie, stream, "dict");
+	rewind(stream);
+	fread(source, 1, sizeof(source) - 1, stream);
+	test = assert_true(ret == 0 && 
+						strstr(source, "dict_nodes[4][2]") != NULL &&
+						strstr(source, "{0x00000003U, 1U},") != NULL &&
+						strstr(source, "{0x80000000U, 4U},") != NULL &&
+						strstr(source, "int dict_lookup(const char* word)")
+						!= NULL, "Trie written out as source");
+	fclose(stream);
+	free_mem(trie);
+	return test;
+}
+
+/*
+ * test_write_source_bad_name
+ * 
+ * Verifies that write_trie_source() rejects names that are not identifiers.
+ * 
+ * returns: 0 upon success, 1 upon failure.
+ */
+int test_write_source_bad_name() {
+	int test;
+	Trie* trie = create_trie();
+	FILE* stream = tmpfile();
+	test = assert_true(write_trie_source(trie, stream, "2dict") == -2 &&
+						write_trie_source(trie, stream, "my-dict") == -2 &&
+						write_trie_source(trie, stream, "") == -2,
+						"Bad source names rejected");
+	fclose(stream);
+	free_mem(trie);
+	return test;
+}
+
 /* ============================= TEST FRAMEWORK ============================= */
 
 /*
@@ -392,6 +1373,41 @@ void free_mem(Trie* head) {
 	free(head);
 }
 
+/*
+ * failing_fsync
+ * 
+ * Stands in for fsync() in the log, failing while failing_syncs is positive.
+ * 
+ * fd: The file descriptor to sync.
+ * 
+ * returns: 0 upon success, -1 upon error or an injected failure.
+ */
+int failing_fsync(int fd) {
+	if (failing_syncs > 0) {
+		failing_syncs--;
+		errno = EIO;
+		return -1;
+	}
+	return fsync(fd);
+}
+
+/*
+ * remove_log_files
+ * 
+ * Removes the log files made by a test and their directory.
+ * 
+ * dir: The directory holding the files named "words".
+ */
+void remove_log_files(char* dir) {
+	char path[64];
+	char* suffixes[] = {".log", ".ckpt", ".tmp", NULL};
+	for (int i = 0; suffixes[i] != NULL; i++) {
+		snprintf(path, sizeof(path), "%s/words%s", dir, suffixes[i]);
+		remove(path);
+	}
+	rmdir(dir);
+}
+
 /*
  * run_test
  * 
@@ -425,7 +1441,26 @@ int main() {
 						&test_clear_multiple, &test_delete_valid,
 						&test_delete_valid_ret, &test_delete_invalid,
 						&test_delete_substring, &test_add_repeat, 
-						&test_check_substring, &test_add_substring, NULL};
+						&test_check_substring, &test_add_substring,
+						&test_longest_prefix_match, &test_longest_prefix_no_match,
+						&test_longest_prefix_unterminated, &test_segment_greedy,
+						&test_segment_greedy_fail, &test_segment_optimal,
+						&test_segment_optimal_fewest, &test_delete_superstring,
+						&test_delete_prefix, &test_delete_prefix_all,
+						&test_delete_prefix_missing, &test_reclaim_nodes,
+						&test_reclaim_nodes_per_trie,
+						&test_union_tries, &test_intersect_tries,
+						&test_difference_tries, &test_set_same_trie,
+						&test_load_words, &test_load_large,
+						&test_load_long_word,
+						&test_filter_membership, &test_filter_many,
+						&test_write_source, &test_write_source_bad_name,
+						&test_rank, &test_select, &test_log_recover,
+						&test_log_checkpoint, &test_log_corrupt,
+						&test_log_sync_failure,
+						&test_log_torn_write,
+						&test_compact, &test_compact_churn,
+						&test_compact_large, NULL};
 
 	for (int i = 0; tests[i] != NULL; i++) {
 		count += run_test(tests[i], &total_tests);
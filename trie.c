@@ -34,14 +34,30 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#define _POSIX_C_SOURCE 200112L // For posix_memalign
+
+#include <ctype.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "trie.h"
 
+#define ARENA_SIZE (1 << 20) // The size and alignment of compact_trie's arenas
 #define ASCII_OFFSET 97 // The offset from 0 our first character is in ASCII
+#define COMPACT_BFS_DEPTH 3 // Levels compact_trie lays out breadth-first
 #define DICT_SIZE 26 // The number of characters in our dict
+#define ENDS_WORD_BIT 31 // The bit marking a word end in generated tries
+#define FILTER_BLOCK_SIZE 64 // Counters per filter block, one cache line
+#define FILTER_CELLS_PER_WORD 12 // Filter counters allotted per expected word
+#define FILTER_MAX_COUNT 255 // Counters stick here, as deletes can't undo them
+#define FILTER_PROBES 4 // Counters set per word, all in the same block
+#define FNV_OFFSET 14695981039346656037ULL // FNV-1a 64-bit offset basis
+#define FNV_PRIME 1099511628211ULL // FNV-1a 64-bit prime
+#define LOAD_BUFFER_SIZE (1 << 20) // The size of each block load_trie reads
+#define MAX_WORD_LENGTH 4096 // Longer words would recurse too deep to free
 
 /*
  * node 
@@ -52,6 +68,50 @@ struct node {
 	struct node* next[DICT_SIZE];
 	int count;
 	bool ends_word;
+	bool in_arena; // If the node is in an arena, so can't be freed alone
+};
+
+/*
+ * filter
+ * 
+ * A blocked counting Bloom filter over the words in a trie. Each word sets
+ * FILTER_PROBES counters within a single block, so a lookup touches one cache
+ * line.
+ */
+struct filter {
+	unsigned char* counters;
+	size_t blocks;
+};
+
+/*
+ * head
+ * 
+ * The allocation behind a trie made by create_trie(). The root node comes
+ * first so a Trie* can be used as a struct node* everywhere.
+ * 
+ * pending holds the roots of subtrees detached from this trie that are waiting
+ * to be reclaimed. Their nodes are handed out again by allocate_node() or freed
+ * by reclaim_trie_nodes().
+ */
+struct head {
+	struct node root;
+	struct filter* filter;
+	struct node** pending;
+	size_t pending_len;
+	size_t pending_cap;
+};
+
+/*
+ * arena
+ * 
+ * A block of nodes allocated together by compact_trie(). Nodes in an arena
+ * can't be freed one at a time, so the arena is freed once none are live.
+ * Arenas are aligned to ARENA_SIZE, so a node finds its arena by masking its
+ * own address.
+ */
+struct arena {
+	size_t live;
+	struct node nodes[];
 };
 
 /*
@@ -74,6 +134,323 @@ bool is_word_valid(char* word) {
 	return valid;
 }
 
+/*
+ * release_node
+ * 
+ * Frees a node, or marks it dead if it is in an arena, freeing the arena once
+ * none of its nodes are live.
+ * 
+ * curr_node: The node to release.
+ * 
+ * returns: none
+ */
+void release_node(struct node* curr_node) {
+	struct arena* arena;
+	if (!curr_node -> in_arena) {
+		free(curr_node);
+		return;
+	}
+	arena = (struct arena*) ((uintptr_t) curr_node & ~(uintptr_t) 
+								(ARENA_SIZE - 1));
+	arena -> live--;
+	if (arena -> live == 0) {
+		free(arena);
+	}
+}
+
+/**
+ * clear_individual
+ * 
+ * A helper function for clear_trie. Recursively calls itself to clear all
+ * nodes, then frees itself.
+ * 
+ * node: The node to clear all children then free itself.
+ * 
+ * returns: none
+ */
+void clear_individual(struct node* curr_node) {
+	struct node* curr_child;
+	for (int i = 0; i < DICT_SIZE; i++) {
+		curr_child = curr_node -> next[i];
+		if (curr_child != NULL) {
+			clear_individual(curr_child);
+		}
+	}
+	release_node(curr_node);
+}
+
+/*
+ * push_pending
+ * 
+ * Queues a subtree detached from a trie for lazy reclamation. Falls back to
+ * freeing it immediately if the queue cannot grow.
+ * 
+ * head: The head of the trie the subtree was detached from.
+ * curr_node: The root of the detached subtree.
+ * 
+ * returns: none
+ */
+void push_pending(struct node* head, struct node* curr_node) {
+	struct head* trie_head = (struct head*) head;
+	struct node** new_pending;
+	size_t new_cap;
+	if (trie_head -> pending_len == trie_head -> pending_cap) {
+		new_cap = trie_head -> pending_cap == 0 ? 64 : 
+					trie_head -> pending_cap * 2;
+		new_pending = (struct node**) realloc(trie_head -> pending, 
+												new_cap * sizeof(struct node*));
+		if (new_pending == NULL) { // Catch error in realloc
+			clear_individual(curr_node);
+			return;
+		}
+		trie_head -> pending = new_pending;
+		trie_head -> pending_cap = new_cap;
+	}
+	trie_head -> pending[trie_head -> pending_len] = curr_node;
+	trie_head -> pending_len++;
+}
+
+/*
+ * pop_pending
+ * 
+ * Takes one node off a trie's reclamation queue, queueing its children in its
+ * place.
+ * 
+ * head: The head of the trie whose queue to take from.
+ * 
+ * returns: The node, or NULL if no nodes are pending.
+ */
+struct node* pop_pending(struct node* head) {
+	struct head* trie_head = (struct head*) head;
+	struct node* curr_node;
+	if (trie_head -> pending_len == 0) {
+		return NULL;
+	}
+	trie_head -> pending_len--;
+	curr_node = trie_head -> pending[trie_head -> pending_len];
+	for (int i = 0; i < DICT_SIZE; i++) {
+		if (curr_node -> next[i] != NULL) {
+			push_pending(head, curr_node -> next[i]);
+		}
+	}
+	return curr_node;
+}
+
+/*
+ * allocate_node
+ * 
+ * Gets an empty node, reusing one from a subtree detached from the trie when
+ * possible.
+ * 
+ * head: The head of the trie the node is for.
+ * 
+ * returns: A pointer to the empty node, or NULL upon error.
+ */
+struct node* allocate_node(struct node* head) {
+	struct node* new_node = pop_pending(head);
+	bool in_arena;
+	if (new_node == NULL) {
+		return (struct node*) calloc(1, sizeof(struct node));
+	}
+	in_arena = new_node -> in_arena;
+	memset(new_node, 0, sizeof(struct node));
+	new_node -> in_arena = in_arena; // Its memory still comes from there
+	return new_node;
+}
+
+/*
+ * get_filter
+ * 
+ * Gets the filter of a trie.
+ * 
+ * head: The head of a trie made by create_trie().
+ * 
+ * returns: The filter, or NULL if the trie has none.
+ */
+struct filter* get_filter(struct node* head) {
+	return ((struct head*) head) -> filter;
+}
+
+/*
+ * hash_letter
+ * 
+ * Extends an FNV-1a hash by one character, so a hash can be built up while
+ * walking down the trie.
+ * 
+ * hash: The hash of the characters so far.
+ * c: The next character.
+ * 
+ * returns: The hash including c.
+ */
+unsigned long long hash_letter(unsigned long long hash, char c) {
+	return (hash ^ (unsigned char) c) * FNV_PRIME;
+}
+
+/*
+ * filter_block
+ * 
+ * Finds the counters block a word's hash falls in. The top half of the hash
+ * is scaled onto the blocks with a multiply and shift rather than a division.
+ * 
+ * filter: The filter to look in.
+ * hash: The FNV-1a hash of the word.
+ * 
+ * returns: A pointer to the first counter of the block.
+ */
+unsigned char* filter_block(struct filter* filter, unsigned long long hash) {
+	return filter -> counters + 
+			(((hash >> 32) * filter -> blocks) >> 32) * FILTER_BLOCK_SIZE;
+}
+
+/*
+ * filter_add
+ * 
+ * Adds a word's hash to the filter.
+ * 
+ * filter: The filter to add to.
+ * hash: The FNV-1a hash of the word.
+ * 
+ * returns: none
+ */
+void filter_add(struct filter* filter, unsigned long long hash) {
+	unsigned char* block = filter_block(filter, hash);
+	unsigned char* counter;
+	for (int i = 0; i < FILTER_PROBES; i++) {
+		counter = block + ((hash >> (6 * i)) & (FILTER_BLOCK_SIZE - 1));
+		if (*counter < FILTER_MAX_COUNT) {
+			*counter += 1;
+		}
+	}
+}
+
+/*
+ * filter_remove
+ * 
+ * Removes a word's hash from the filter. The word must have been added.
+ * 
+ * filter: The filter to remove from.
+ * hash: The FNV-1a hash of the word.
+ * 
+ * returns: none
+ */
+void filter_remove(struct filter* filter, unsigned long long hash) {
+	unsigned char* block = filter_block(filter, hash);
+	unsigned char* counter;
+	for (int i = 0; i < FILTER_PROBES; i++) {
+		counter = block + ((hash >> (6 * i)) & (FILTER_BLOCK_SIZE - 1));
+		if (*counter < FILTER_MAX_COUNT) {
+			*counter -= 1;
+		}
+	}
+}
+
+/*
+ * filter_may_contain
+ * 
+ * Checks if a word may be in the filter.
+ * 
+ * filter: The filter to check.
+ * hash: The FNV-1a hash of the word.
+ * 
+ * returns: false if the word is definitely not in the filter, true otherwise.
+ */
+bool filter_may_contain(struct filter* filter, unsigned long long hash) {
+	unsigned char* block = filter_block(filter, hash);
+	bool found = true;
+	for (int i = 0; i < FILTER_PROBES && found; i++) {
+		found = block[(hash >> (6 * i)) & (FILTER_BLOCK_SIZE - 1)] != 0;
+	}
+	return found;
+}
+
+/*
+ * filter_add_nodes
+ * 
+ * A helper function for rebuild_trie_filter and union_nodes. Recursively adds
+ * every word under a node to the filter.
+ * 
+ * filter: The filter to add to.
+ * curr_node: The node to add the words under.
+ * hash: The FNV-1a hash of the characters leading to curr_node.
+ * 
+ * returns: none
+ */
+void filter_add_nodes(struct filter* filter, struct node* curr_node, 
+						unsigned long long hash) {
+	if (curr_node -> ends_word) {
+		filter_add(filter, hash);
+	}
+	for (int i = 0; i < DICT_SIZE; i++) {
+		if (curr_node -> next[i] != NULL) {
+			filter_add_nodes(filter, curr_node -> next[i], 
+								hash_letter(hash, i + ASCII_OFFSET));
+		}
+	}
+}
+
+/*
+ * insert_word
+ * 
+ * Inserts a word that has already been validated into the trie. The nodes the
+ * word needs are allocated before anything is linked in, so the trie is left
+ * unchanged upon failure.
+ * 
+ * head: The head node of the trie to add the word to.
+ * word: The lowercase word to add. Does not need to be null-terminated.
+ * len: The number of characters in word.
+ * 
+ * returns: 1 if the word was added to the trie, 0 if the word was already in 
+ * 			the trie, or -3 upon failure.
+ */
+int insert_word(struct node* head, char* word, size_t len) {
+	struct node* curr_node = head;
+	struct node* chain = NULL; // The new nodes for the rest of the word
+	struct node* new_node;
+	unsigned long long hash;
+	size_t depth = 0;
+	while (depth < len && curr_node -> next[word[depth] - ASCII_OFFSET] != NULL) {
+		curr_node = curr_node -> next[word[depth] - ASCII_OFFSET];
+		depth++;
+	}
+	if (depth == len && curr_node -> ends_word) {
+		return 0;
+	}
+	for (size_t i = len; i > depth; i--) { // Build the missing nodes bottom-up
+		new_node = allocate_node(head);
+		if (new_node == NULL) { // Catch error in allocation
+			if (chain != NULL) {
+				clear_individual(chain);
+			}
+			return -3;
+		}
+		new_node -> count = 1;
+		new_node -> ends_word = i == len;
+		if (chain != NULL) {
+			new_node -> next[word[i] - ASCII_OFFSET] = chain;
+		}
+		chain = new_node;
+	}
+	if (chain != NULL) {
+		curr_node -> next[word[depth] - ASCII_OFFSET] = chain;
+	} else {
+		curr_node -> ends_word = true;
+	}
+	curr_node = head;
+	head -> count += 1;
+	for (size_t i = 0; i < depth; i++) {
+		curr_node = curr_node -> next[word[i] - ASCII_OFFSET];
+		curr_node -> count += 1;
+	}
+	if (get_filter(head) != NULL) {
+		hash = FNV_OFFSET;
+		for (size_t i = 0; i < len; i++) {
+			hash = hash_letter(hash, word[i]);
+		}
+		filter_add(get_filter(head), hash);
+	}
+	return 1;
+}
+
 /*
  * add_to_trie
  * 
@@ -84,33 +461,15 @@ bool is_word_valid(char* word) {
  * 
  * returns: 1 if the word was added to the trie, 0 if the word was already in 
  * 			the trie, -1 upon failure due to the maximum size of the trie being 
- * 			exceeded, -2 upon bad words input, or -3 upon other failure.
+ * 			exceeded, -2 upon bad words input (including words longer than
+ * 			MAX_WORD_LENGTH), or -3 upon other failure.
  */
 int add_to_trie(struct node* head, char* word) {
-	struct node* new_node;
-	int ret = 1;
-	if (!is_word_valid(word)) {
+	int ret;
+	if (!is_word_valid(word) || strlen(word) > MAX_WORD_LENGTH) {
 		ret = -2;
-	} else if (check_trie(head, word) == 1) {
-		ret = 0;
 	} else {
-		head -> count += 1;
-		while (*word != '\0') {
-			if (head -> next[*word - ASCII_OFFSET] == 0) { // If next node DNE
-				new_node = (struct node*) calloc(1, sizeof(struct node));
-				if (new_node == NULL) { // Catch error in calloc
-					return -3;
-				}
-				head -> next[*word - ASCII_OFFSET] = new_node;
-				head = new_node;
-			} else {
-				head = head -> next[*word - ASCII_OFFSET];
-			}
-			
-			head -> count += 1;
-			word++;
-		}
-		head -> ends_word = true;
+		ret = insert_word(head, word, strlen(word));
 	}
 	return ret;
 }
@@ -128,8 +487,14 @@ int add_to_trie(struct node* head, char* word) {
  */
 int check_trie(struct node* head, char* word) {
 	bool in_trie = 1;
+	unsigned long long hash = FNV_OFFSET;
 	if (!is_word_valid(word)) {
 		in_trie = 0;
+	} else if (get_filter(head) != NULL) { // Rule out most misses up front
+		for (char* c = word; *c != '\0'; c++) {
+			hash = hash_letter(hash, *c);
+		}
+		in_trie = filter_may_contain(get_filter(head), hash);
 	}
 	while (*word != '\0' && in_trie) {
 		if (head -> next[*word - ASCII_OFFSET] != NULL) {
@@ -142,57 +507,191 @@ int check_trie(struct node* head, char* word) {
 	return in_trie && head -> ends_word; // The final node must end the word too
 }
 
-/**
- * clear_individual
+/*
+ * clear_trie
  * 
- * A helper function for clear_trie. Recursively calls itself to clear all
- * nodes, then frees itself.
+ * Deletes all entries in the trie, including nodes still waiting to be
+ * reclaimed. Does not delete the head node.
  * 
- * node: The node to clear all children then free itself.
+ * head: The head of the trie to clear.
+ * 
+ * returns: 0 upon success, -1 upon error.
+ */
+int clear_trie(struct node* head) {
+	for (int i = 0; i < DICT_SIZE; i++) {
+		if (head -> next[i] != NULL) {
+			clear_individual(head -> next[i]);
+		}
+		head -> next[i] = NULL;
+	}
+	head -> count = 0;
+	head -> ends_word = false;
+	reclaim_trie_nodes(head, 0);
+	if (get_filter(head) != NULL) {
+		memset(get_filter(head) -> counters, 0, 
+				get_filter(head) -> blocks * FILTER_BLOCK_SIZE);
+	}
+	return 0;
+}
+
+/*
+ * count_nodes
+ * 
+ * Recursively counts a node and all nodes below it.
+ * 
+ * curr_node: The node to count from.
+ * 
+ * returns: The number of nodes.
+ */
+size_t count_nodes(struct node* curr_node) {
+	size_t count = 1;
+	for (int i = 0; i < DICT_SIZE; i++) {
+		if (curr_node -> next[i] != NULL) {
+			count += count_nodes(curr_node -> next[i]);
+		}
+	}
+	return count;
+}
+
+/*
+ * append_preorder
+ * 
+ * A helper function for compact_trie. Recursively appends a node and all
+ * nodes below it to the layout in depth-first order, so each path down the
+ * trie is stored contiguously.
+ * 
+ * curr_node: The node to append from.
+ * order: The layout being built.
+ * len: The number of nodes in the layout so far.
  * 
  * returns: none
  */
-void clear_individual(struct node* curr_node) {
-	struct node* curr_child;
+void append_preorder(struct node* curr_node, struct node** order, size_t* len) {
+	order[*len] = curr_node;
+	*len += 1;
 	for (int i = 0; i < DICT_SIZE; i++) {
-		curr_child = curr_node -> next[i];
-		if (curr_child != NULL) {
-			clear_individual(curr_child);
+		if (curr_node -> next[i] != NULL) {
+			append_preorder(curr_node -> next[i], order, len);
 		}
 	}
-	free(curr_node);
 }
 
 /*
- * clear_trie
+ * compact_trie
  * 
- * Deletes all entries in the trie. Does not delete the head node.
+ * Moves every node of the trie into new contiguous arenas, restoring the
+ * locality lost to churn. The top COMPACT_BFS_DEPTH levels, which every
+ * lookup passes through, are laid out breadth-first; each subtree below them
+ * is laid out depth-first. The old nodes are freed, which also frees old
+ * arenas whose slots churn had left dead, as those slots are never reused.
  * 
- * head: The head of the trie to clear.
+ * head: The head of the trie to compact. The head itself is not moved.
  * 
- * returns: 0 upon success, -1 upon error.
+ * returns: The number of nodes moved, or -3 upon failure to allocate, in
+ * 			which case the trie is unchanged.
  */
-int clear_trie(struct node* head) {
+int compact_trie(struct node* head) {
+	size_t per_arena = (ARENA_SIZE - sizeof(struct arena)) / 
+						sizeof(struct node); // Nodes that fit in a full arena
+	struct arena** arenas;
+	struct node** order; // The old nodes, in their new order
+	struct node* new_node;
+	size_t num_nodes;
+	size_t num_arenas;
+	size_t arena_len;
+	size_t len = 0;
+	size_t level_start = 0;
+	size_t level_end;
+	int ret = 0;
+	if (head == NULL) {
+		return -3;
+	}
+	num_nodes = count_nodes(head) - 1;
+	if (num_nodes == 0) {
+		return 0;
+	}
+	num_arenas = (num_nodes + per_arena - 1) / per_arena;
+	order = (struct node**) malloc(num_nodes * sizeof(struct node*));
+	arenas = (struct arena**) calloc(num_arenas, sizeof(struct arena*));
+	for (size_t j = 0; j < num_arenas && order != NULL && arenas != NULL &&
+			ret == 0; j++) {
+		arena_len = j < num_arenas - 1 ? per_arena : num_nodes - j * per_arena;
+		ret = posix_memalign((void**) &arenas[j], ARENA_SIZE, 
+						sizeof(struct arena) + arena_len * sizeof(struct node));
+		if (ret == 0) {
+			arenas[j] -> live = arena_len;
+		}
+	}
+	if (order == NULL || arenas == NULL || ret != 0) { // Catch error in malloc
+		for (size_t j = 0; arenas != NULL && j < num_arenas; j++) {
+			free(arenas[j]);
+		}
+		free(order);
+		free(arenas);
+		return -3;
+	}
 	for (int i = 0; i < DICT_SIZE; i++) {
 		if (head -> next[i] != NULL) {
-			clear_individual(head -> next[i]);
+			order[len] = head -> next[i];
+			len++;
 		}
-		head -> next[i] = NULL;
 	}
-	head -> count = 0;
-	head -> ends_word = false;
-	return 0;
+	for (int depth = 1; depth < COMPACT_BFS_DEPTH; depth++) {
+		level_end = len;
+		for (size_t j = level_start; j < level_end; j++) {
+			for (int i = 0; i < DICT_SIZE; i++) {
+				if (order[j] -> next[i] != NULL) {
+					order[len] = order[j] -> next[i];
+					len++;
+				}
+			}
+		}
+		level_start = level_end;
+	}
+	level_end = len;
+	for (size_t j = level_start; j < level_end; j++) {
+		for (int i = 0; i < DICT_SIZE; i++) {
+			if (order[j] -> next[i] != NULL) {
+				append_preorder(order[j] -> next[i], order, &len);
+			}
+		}
+	}
+	for (size_t j = 0; j < num_nodes; j++) {
+		new_node = &arenas[j / per_arena] -> nodes[j % per_arena];
+		*new_node = *order[j];
+		new_node -> in_arena = true;
+		order[j] -> next[0] = new_node; // Leave the new address behind
+	}
+	for (size_t j = 0; j < num_nodes; j++) {
+		new_node = &arenas[j / per_arena] -> nodes[j % per_arena];
+		for (int i = 0; i < DICT_SIZE; i++) {
+			if (new_node -> next[i] != NULL) {
+				new_node -> next[i] = new_node -> next[i] -> next[0];
+			}
+		}
+	}
+	for (int i = 0; i < DICT_SIZE; i++) {
+		if (head -> next[i] != NULL) {
+			head -> next[i] = head -> next[i] -> next[0];
+		}
+	}
+	for (size_t j = 0; j < num_nodes; j++) {
+		release_node(order[j]);
+	}
+	free(order);
+	free(arenas);
+	return num_nodes;
 }
 
 /*
  * create_trie
  * 
- * Creates an empty trie.
+ * Creates an empty trie, with room for a filter alongside the head node.
  * 
  * returns: A pointer to the head of an empty trie, or NULL upon error.
  */
 struct node* create_trie() {
-	return (struct node*)calloc(1, sizeof(struct node));
+	return (struct node*)calloc(1, sizeof(struct head));
 }
 
 /*
@@ -207,32 +706,898 @@ struct node* create_trie() {
  * 				the trie, and -1 upon error.
  */
 int delete_from_trie(struct node* head, char* word) {
-	struct node* curr_node = head;
-	int ret = 1;
+	struct filter* filter = get_filter(head);
 	struct node* next_node;
-	char* curr_letter = word;
-	if (!check_trie(head, word)) {
+	unsigned long long hash = FNV_OFFSET;
+	bool unlinked = false;
+	int ret = 1;
+	if (check_trie(head, word) != 1) {
 		ret = 0;
 	} else {
-		if (*curr_letter != '\0') {
-			next_node = curr_node -> next[*curr_letter - ASCII_OFFSET];
-			if (next_node -> count == 1) {
-				curr_node -> next[*curr_letter - ASCII_OFFSET] = NULL;
-			}
+		for (char* c = word; *c != '\0' && filter != NULL; c++) {
+			hash = hash_letter(hash, *c);
 		}
-		while (*curr_letter != '\0') {
-			curr_node = next_node;
-			curr_node -> count -= 1;
-			if (*(curr_letter + 1) != '\0') {
-				next_node = curr_node -> next[*(curr_letter + 1) - ASCII_OFFSET];
+		head -> count -= 1;
+		while (*word != '\0' && !unlinked) {
+			next_node = head -> next[*word - ASCII_OFFSET];
+			if (next_node -> count == 1) { // Only this word is below here
+				head -> next[*word - ASCII_OFFSET] = NULL;
+				clear_individual(next_node);
+				unlinked = true;
 			} else {
-				curr_node -> ends_word = false;
-			}
-			if (curr_node -> count == 0) {
-				free(curr_node);
+				next_node -> count -= 1;
+				head = next_node;
+				word++;
 			}
-			curr_letter++;
 		}
+		if (!unlinked) {
+			head -> ends_word = false;
+		}
+		if (filter != NULL) {
+			filter_remove(filter, hash);
+		}
+	}
+	return ret;
+}
+
+/*
+ * delete_prefix_from_trie
+ * 
+ * Deletes every word starting with a prefix from the trie in one descent. The
+ * detached nodes are reclaimed lazily, either by later calls to add_to_trie()
+ * or by reclaim_trie_nodes().
+ * 
+ * head: The head of the trie to delete entries from.
+ * prefix: The lowercase prefix of the words to delete. An empty prefix deletes
+ * 			every word.
+ * 
+ * returns: The number of words deleted from the trie, or -1 upon error.
+ */
+int delete_prefix_from_trie(struct node* head, char* prefix) {
+	struct node* curr_node = head;
+	struct node* next_node;
+	char* curr_letter = prefix;
+	int deleted;
+	if (head == NULL || prefix == NULL) {
+		return -1;
+	}
+	if (!is_word_valid(prefix)) {
+		return 0;
+	}
+	while (*curr_letter != '\0' && curr_node != NULL) {
+		curr_node = curr_node -> next[*curr_letter - ASCII_OFFSET];
+		curr_letter++;
+	}
+	if (curr_node == NULL || curr_node -> count == 0) {
+		return 0;
+	}
+	deleted = curr_node -> count;
+	if (*prefix == '\0') {
+		for (int i = 0; i < DICT_SIZE; i++) {
+			if (head -> next[i] != NULL) {
+				push_pending(head, head -> next[i]);
+				head -> next[i] = NULL;
+			}
+		}
+		head -> count = 0;
+		head -> ends_word = false;
+		return deleted;
+	}
+	head -> count -= deleted;
+	curr_node = head;
+	curr_letter = prefix;
+	while (*curr_letter != '\0') {
+		next_node = curr_node -> next[*curr_letter - ASCII_OFFSET];
+		if (next_node -> count == deleted) { // Nothing else is below here
+			curr_node -> next[*curr_letter - ASCII_OFFSET] = NULL;
+			push_pending(head, next_node);
+			break;
+		}
+		next_node -> count -= deleted;
+		curr_node = next_node;
+		curr_letter++;
+	}
+	return deleted;
+}
+
+/*
+ * difference_nodes
+ * 
+ * A helper function for difference_tries. Walks two nodes in lockstep,
+ * removing words under other from dest. Only paths present in both tries are
+ * visited.
+ * 
+ * head: The head of the trie dest is in.
+ * dest: The node to remove words from.
+ * other: The matching node of the trie holding the words to remove.
+ * 
+ * returns: The number of words left under dest.
+ */
+int difference_nodes(struct node* head, struct node* dest, 
+						struct node* other) {
+	int count = 0;
+	if (other -> ends_word) {
+		dest -> ends_word = false;
+	}
+	for (int i = 0; i < DICT_SIZE; i++) {
+		if (dest -> next[i] != NULL && other -> next[i] != NULL && 
+				difference_nodes(head, dest -> next[i], 
+									other -> next[i]) == 0) {
+			push_pending(head, dest -> next[i]);
+			dest -> next[i] = NULL;
+		}
+		if (dest -> next[i] != NULL) {
+			count += dest -> next[i] -> count;
+		}
+	}
+	dest -> count = count + dest -> ends_word;
+	return dest -> count;
+}
+
+/*
+ * difference_tries
+ * 
+ * Removes every word in other from dest. Subtrees only dest has are kept
+ * without being visited.
+ * 
+ * dest: The head of the trie to remove words from.
+ * other: The head of the trie holding the words to remove. Left unchanged.
+ * 
+ * returns: The number of words left in dest, or -1 upon error.
+ */
+int difference_tries(struct node* dest, struct node* other) {
+	if (dest == NULL || other == NULL || dest == other) {
+		return -1;
+	}
+	return difference_nodes(dest, dest, other);
+}
+
+/*
+ * disable_trie_filter
+ * 
+ * Removes the filter from a trie, freeing it.
+ * 
+ * head: The head of the trie to remove the filter from.
+ * 
+ * returns: 0 upon success, -1 upon error.
+ */
+int disable_trie_filter(struct node* head) {
+	struct filter* filter;
+	if (head == NULL) {
+		return -1;
+	}
+	filter = get_filter(head);
+	if (filter != NULL) {
+		free(filter -> counters);
+		free(filter);
+		((struct head*) head) -> filter = NULL;
+	}
+	return 0;
+}
+
+/*
+ * enable_trie_filter
+ * 
+ * Gives a trie a counting Bloom filter, sized for a number of words, that
+ * check_trie() consults before walking the trie. Replaces any existing filter.
+ * 
+ * head: The head of the trie to filter.
+ * expected_words: The number of words the filter is sized for.
+ * 
+ * returns: 0 upon success, -1 upon error, or -3 upon failure to allocate.
+ */
+int enable_trie_filter(struct node* head, size_t expected_words) {
+	struct filter* filter;
+	if (head == NULL) {
+		return -1;
+	}
+	filter = (struct filter*) malloc(sizeof(struct filter));
+	if (filter == NULL) { // Catch error in malloc
+		return -3;
+	}
+	filter -> blocks = expected_words * FILTER_CELLS_PER_WORD / FILTER_BLOCK_SIZE;
+	if (filter -> blocks == 0) {
+		filter -> blocks = 1;
+	}
+	filter -> counters = (unsigned char*) aligned_alloc(FILTER_BLOCK_SIZE, 
+							filter -> blocks * FILTER_BLOCK_SIZE);
+	if (filter -> counters == NULL) { // Catch error in aligned_alloc
+		free(filter);
+		return -3;
+	}
+	disable_trie_filter(head);
+	((struct head*) head) -> filter = filter;
+	return rebuild_trie_filter(head);
+}
+
+/*
+ * intersect_nodes
+ * 
+ * A helper function for intersect_tries. Walks two nodes in lockstep, keeping
+ * only the words under dest that are also under other.
+ * 
+ * head: The head of the trie dest is in.
+ * dest: The node to remove words from.
+ * other: The matching node of the trie holding the words to keep.
+ * 
+ * returns: The number of words left under dest.
+ */
+int intersect_nodes(struct node* head, struct node* dest, 
+						struct node* other) {
+	int count = 0;
+	dest -> ends_word = dest -> ends_word && other -> ends_word;
+	for (int i = 0; i < DICT_SIZE; i++) {
+		if (dest -> next[i] != NULL && (other -> next[i] == NULL || 
+				intersect_nodes(head, dest -> next[i], 
+									other -> next[i]) == 0)) {
+			push_pending(head, dest -> next[i]); // Dropped whole, freed lazily
+			dest -> next[i] = NULL;
+		}
+		if (dest -> next[i] != NULL) {
+			count += dest -> next[i] -> count;
+		}
+	}
+	dest -> count = count + dest -> ends_word;
+	return dest -> count;
+}
+
+/*
+ * intersect_tries
+ * 
+ * Removes every word from dest that is not also in other. Subtrees only dest
+ * has are dropped without being visited.
+ * 
+ * dest: The head of the trie to remove words from.
+ * other: The head of the trie holding the words to keep. Left unchanged.
+ * 
+ * returns: The number of words left in dest, or -1 upon error.
+ */
+int intersect_tries(struct node* dest, struct node* other) {
+	if (dest == NULL || other == NULL || dest == other) {
+		return -1;
+	}
+	return intersect_nodes(dest, dest, other);
+}
+
+/*
+ * is_separator
+ * 
+ * Checks if a character separates words in loaded text.
+ * 
+ * c: The character to check.
+ * 
+ * returns: true if c is whitespace, false otherwise.
+ */
+bool is_separator(char c) {
+	return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || 
+			c == '\f';
+}
+
+/*
+ * load_trie
+ * 
+ * Adds every whitespace-separated word in a stream to the trie. The stream is
+ * read in large blocks and words are lowercased and inserted straight out of
+ * the read buffer, without being copied. Words with characters other than
+ * letters, or longer than MAX_WORD_LENGTH, are rejected.
+ * 
+ * head: The head of the trie to add the words to.
+ * stream: The stream to read words from.
+ * stats: Counters for the load, or NULL. Reset before loading.
+ * 
+ * returns: 0 upon success, -1 upon a read error, or -3 upon other failure.
+ */
+int load_trie(struct node* head, FILE* stream, struct load_stats* stats) {
+	struct load_stats local_stats;
+	char* buffer;
+	size_t filled = 0; // Characters carried over from the last block
+	size_t bytes;
+	size_t end;
+	size_t pos;
+	size_t start;
+	bool valid;
+	bool eof = false;
+	bool skipping = false; // If the word at the start of the block is too long
+	int ret = 0;
+	if (head == NULL || stream == NULL) {
+		return -3;
+	}
+	if (stats == NULL) {
+		stats = &local_stats;
+	}
+	memset(stats, 0, sizeof(struct load_stats));
+	buffer = (char*) malloc(LOAD_BUFFER_SIZE);
+	if (buffer == NULL) { // Catch malloc error
+		ret = -3;
+	}
+	while (ret == 0 && !eof) {
+		bytes = fread(buffer + filled, 1, LOAD_BUFFER_SIZE - filled, stream);
+		stats -> bytes_read += bytes;
+		if (bytes == 0) {
+			if (ferror(stream)) {
+				ret = -1;
+				break;
+			}
+			eof = true;
+		}
+		end = filled + bytes;
+		pos = 0;
+		start = end;
+		if (skipping && (end == 0 || is_separator(buffer[0]))) {
+			stats -> words_read += 1; // The long word ended with the last block
+			stats -> words_rejected += 1;
+			skipping = false;
+		}
+		while (pos < end && ret == 0) {
+			while (pos < end && is_separator(buffer[pos])) {
+				pos++;
+			}
+			if (pos == end) {
+				start = end;
+				break;
+			}
+			start = pos;
+			valid = true;
+			while (pos < end && !is_separator(buffer[pos])) {
+				if (buffer[pos] >= 'A' && buffer[pos] <= 'Z') {
+					buffer[pos] += 'a' - 'A';
+				} else if (buffer[pos] - ASCII_OFFSET < 0 || 
+							buffer[pos] - ASCII_OFFSET >= DICT_SIZE) {
+					valid = false;
+				}
+				pos++;
+			}
+			if (pos == end && !eof) { // The word may continue in the next block
+				break;
+			}
+			stats -> words_read += 1;
+			if (!valid || skipping || pos - start > MAX_WORD_LENGTH) {
+				stats -> words_rejected += 1;
+				skipping = false;
+				continue;
+			}
+			ret = insert_word(head, buffer + start, pos - start);
+			if (ret < 0) {
+				ret = -3;
+				break;
+			}
+			stats -> words_added += ret;
+			ret = 0;
+		}
+		if (end - start > MAX_WORD_LENGTH) { // Too long to carry over
+			skipping = true;
+			filled = 0;
+		} else {
+			filled = end - start;
+			memmove(buffer, buffer + start, filled);
+		}
+	}
+	free(buffer);
+	return ret;
+}
+
+/*
+ * longest_prefix_in_trie
+ * 
+ * Finds the longest word in the trie that is a prefix of a buffer, using a
+ * single descent of the trie.
+ * 
+ * head: The head of the trie to check.
+ * text: The buffer to match against. Does not need to be null-terminated.
+ * len: The number of characters of text to consider.
+ * 
+ * returns: The length of the longest word in the trie that text starts with,
+ * 			0 if no non-empty word matches, or -1 upon an error.
+ */
+int longest_prefix_in_trie(struct node* head, char* text, size_t len) {
+	int longest = 0;
+	int index;
+	if (head == NULL || text == NULL) {
+		return -1;
+	}
+	for (size_t i = 0; i < len; i++) {
+		index = text[i] - ASCII_OFFSET;
+		if (index < 0 || index >= DICT_SIZE || head -> next[index] == NULL) {
+			break;
+		}
+		head = head -> next[index];
+		if (head -> ends_word) {
+			longest = i + 1;
+		}
+	}
+	return longest;
+}
+
+/*
+ * reclaim_trie_nodes
+ * 
+ * Frees nodes left behind by delete_prefix_from_trie(), intersect_tries() and
+ * difference_tries().
+ * 
+ * head: The head of the trie whose detached nodes to free.
+ * max_nodes: The most nodes to free, or 0 or less to free all pending nodes.
+ * 
+ * returns: The number of nodes freed, or -1 upon error.
+ */
+int reclaim_trie_nodes(struct node* head, int max_nodes) {
+	struct head* trie_head = (struct head*) head;
+	int freed = 0;
+	if (head == NULL) {
+		return -1;
+	}
+	while (trie_head -> pending_len > 0 && 
+			(max_nodes <= 0 || freed < max_nodes)) {
+		release_node(pop_pending(head));
+		freed++;
+	}
+	if (trie_head -> pending_len == 0) {
+		free(trie_head -> pending);
+		trie_head -> pending = NULL;
+		trie_head -> pending_cap = 0;
+	}
+	return freed;
+}
+
+/*
+ * rank_in_trie
+ * 
+ * Counts the words in the trie that sort before a word, using the word counts
+ * kept in each node. The word does not need to be in the trie.
+ * 
+ * head: The head of the trie to check.
+ * word: A string with the lowercase word (consisting only of [a-z]) to rank.
+ * 
+ * returns: The number of words in the trie that sort before word, or -2 upon
+ * 			bad word input.
+ */
+int rank_in_trie(struct node* head, char* word) {
+	int rank = 0;
+	if (!is_word_valid(word)) {
+		return -2;
+	}
+	while (*word != '\0' && head != NULL) {
+		if (head -> ends_word) { // The word ending here is a prefix of word
+			rank++;
+		}
+		for (int i = 0; i < *word - ASCII_OFFSET; i++) {
+			if (head -> next[i] != NULL) {
+				rank += head -> next[i] -> count;
+			}
+		}
+		head = head -> next[*word - ASCII_OFFSET];
+		word++;
+	}
+	return rank;
+}
+
+/*
+ * rebuild_trie_filter
+ * 
+ * Refills the filter of a trie from its words. Bulk deletes leave the words
+ * they remove counted in the filter, which only costs extra false positives;
+ * rebuilding clears them out.
+ * 
+ * head: The head of the trie whose filter to rebuild.
+ * 
+ * returns: 0 upon success, or -1 upon error (including having no filter).
+ */
+int rebuild_trie_filter(struct node* head) {
+	struct filter* filter;
+	if (head == NULL || get_filter(head) == NULL) {
+		return -1;
+	}
+	filter = get_filter(head);
+	memset(filter -> counters, 0, filter -> blocks * FILTER_BLOCK_SIZE);
+	filter_add_nodes(filter, head, FNV_OFFSET);
+	return 0;
+}
+
+/*
+ * segment_greedy_with_trie
+ * 
+ * Splits a buffer into words from the trie, repeatedly taking the longest
+ * word starting at the current position.
+ * 
+ * head: The head of the trie holding the dictionary.
+ * text: The buffer to segment. Does not need to be null-terminated.
+ * len: The number of characters of text to segment.
+ * bounds: An array which receives the end offset of each word, in order.
+ * max_bounds: The number of entries available in bounds.
+ * 
+ * returns: The number of words text was split into, -1 if text could not be
+ * 			segmented, -2 if more than max_bounds words are needed, or -3 upon
+ * 			other failure.
+ */
+int segment_greedy_with_trie(struct node* head, char* text, size_t len, 
+								size_t* bounds, size_t max_bounds) {
+	size_t pos = 0;
+	size_t words = 0;
+	int match;
+	if (head == NULL || text == NULL || (bounds == NULL && max_bounds > 0)) {
+		return -3;
+	}
+	while (pos < len) {
+		match = longest_prefix_in_trie(head, text + pos, len - pos);
+		if (match <= 0) {
+			return -1;
+		}
+		if (words == max_bounds) {
+			return -2;
+		}
+		pos += match;
+		bounds[words] = pos;
+		words++;
+	}
+	return words;
+}
+
+/*
+ * segment_optimal_with_trie
+ * 
+ * Splits a buffer into the fewest possible words from the trie. Each position
+ * reachable by a segmentation is walked down the trie once, so the cost is
+ * O(len * longest word).
+ * 
+ * head: The head of the trie holding the dictionary.
+ * text: The buffer to segment. Does not need to be null-terminated.
+ * len: The number of characters of text to segment.
+ * bounds: An array which receives the end offset of each word, in order.
+ * max_bounds: The number of entries available in bounds.
+ * 
+ * returns: The number of words text was split into, -1 if text could not be
+ * 			segmented, -2 if more than max_bounds words are needed, or -3 upon
+ * 			other failure.
+ */
+int segment_optimal_with_trie(struct node* head, char* text, size_t len, 
+								size_t* bounds, size_t max_bounds) {
+	struct node* curr_node;
+	int* best; // Fewest words needed to reach each offset, -1 if unreachable
+	size_t* prev; // The start of the last word in the best path to each offset
+	int index;
+	int ret;
+	size_t pos;
+	if (head == NULL || text == NULL || (bounds == NULL && max_bounds > 0)) {
+		return -3;
+	}
+	best = (int*) malloc((len + 1) * sizeof(int));
+	prev = (size_t*) malloc((len + 1) * sizeof(size_t));
+	if (best == NULL || prev == NULL) { // Catch error in malloc
+		free(best);
+		free(prev);
+		return -3;
+	}
+	best[0] = 0;
+	for (size_t i = 1; i <= len; i++) {
+		best[i] = -1;
+	}
+	for (size_t i = 0; i < len; i++) {
+		if (best[i] < 0) {
+			continue;
+		}
+		curr_node = head;
+		for (size_t j = i; j < len; j++) {
+			index = text[j] - ASCII_OFFSET;
+			if (index < 0 || index >= DICT_SIZE || 
+					curr_node -> next[index] == NULL) {
+				break;
+			}
+			curr_node = curr_node -> next[index];
+			if (curr_node -> ends_word && 
+					(best[j + 1] < 0 || best[i] + 1 < best[j + 1])) {
+				best[j + 1] = best[i] + 1;
+				prev[j + 1] = i;
+			}
+		}
+	}
+	ret = best[len];
+	if (ret < 0) {
+		ret = -1;
+	} else if ((size_t) ret > max_bounds) {
+		ret = -2;
+	} else {
+		pos = len;
+		for (int k = ret - 1; k >= 0; k--) {
+			bounds[k] = pos;
+			pos = prev[pos];
+		}
+	}
+	free(best);
+	free(prev);
+	return ret;
+}
+
+/*
+ * select_from_trie
+ * 
+ * Finds the word at a position in the trie's sorted order, using the word
+ * counts kept in each node to skip whole subtrees.
+ * 
+ * head: The head of the trie to look in.
+ * n: The position of the word, counting from 0.
+ * buffer: Receives the null-terminated word.
+ * buffer_len: The number of characters available in buffer.
+ * 
+ * returns: The length of the word, -1 if n is not a position in the trie, or
+ * 			-2 if the word does not fit in buffer.
+ */
+int select_from_trie(struct node* head, int n, char* buffer, 
+						size_t buffer_len) {
+	size_t len = 0;
+	bool found = false;
+	if (head == NULL || n < 0 || n >= head -> count) {
+		return -1;
+	}
+	while (!found) {
+		if (head -> ends_word) {
+			if (n == 0) {
+				found = true;
+				continue;
+			}
+			n--;
+		}
+		for (int i = 0; i < DICT_SIZE; i++) {
+			if (head -> next[i] == NULL) {
+				continue;
+			}
+			if (n < head -> next[i] -> count) {
+				if (len + 1 >= buffer_len) {
+					return -2;
+				}
+				buffer[len] = i + ASCII_OFFSET;
+				len++;
+				head = head -> next[i];
+				break;
+			}
+			n -= head -> next[i] -> count;
+		}
+	}
+	if (len >= buffer_len) {
+		return -2;
+	}
+	buffer[len] = '\0';
+	return len;
+}
+
+/*
+ * union_nodes
+ * 
+ * A helper function for union_tries. Walks two nodes in lockstep, moving the
+ * words under src into dest. Subtrees only src has are grafted onto dest
+ * whole, and the src nodes that overlap dest are freed. The words new to dest
+ * are added to its filter, if it has one.
+ * 
+ * dest: The node to add words to.
+ * src: The matching node of the trie to take words from.
+ * filter: The filter of dest's trie, or NULL.
+ * hash: The FNV-1a hash of the characters leading to dest.
+ * 
+ * returns: The number of words under dest.
+ */
+int union_nodes(struct node* dest, struct node* src, struct filter* filter, 
+				unsigned long long hash) {
+	int count = 0;
+	if (filter != NULL && src -> ends_word && !dest -> ends_word) {
+		filter_add(filter, hash);
+	}
+	dest -> ends_word = dest -> ends_word || src -> ends_word;
+	for (int i = 0; i < DICT_SIZE; i++) {
+		if (src -> next[i] != NULL) {
+			if (dest -> next[i] == NULL) {
+				dest -> next[i] = src -> next[i];
+				if (filter != NULL) {
+					filter_add_nodes(filter, dest -> next[i], 
+										hash_letter(hash, i + ASCII_OFFSET));
+				}
+			} else {
+				union_nodes(dest -> next[i], src -> next[i], filter, 
+							hash_letter(hash, i + ASCII_OFFSET));
+				release_node(src -> next[i]);
+			}
+			src -> next[i] = NULL;
+		}
+		if (dest -> next[i] != NULL) {
+			count += dest -> next[i] -> count;
+		}
+	}
+	dest -> count = count + dest -> ends_word;
+	return dest -> count;
+}
+
+/*
+ * union_tries
+ * 
+ * Moves every word in src into dest, leaving src empty. Subtrees only src has
+ * are grafted onto dest without being visited or copied.
+ * 
+ * dest: The head of the trie to add words to.
+ * src: The head of the trie to take words from. Emptied, but not freed.
+ * 
+ * returns: The number of words in dest, or -1 upon error.
+ */
+int union_tries(struct node* dest, struct node* src) {
+	int ret;
+	if (dest == NULL || src == NULL || dest == src) {
+		return -1;
+	}
+	ret = union_nodes(dest, src, get_filter(dest), FNV_OFFSET);
+	clear_trie(src); // Only resets the head and filter, its nodes are moved
+	return ret;
+}
+
+/*
+ * is_identifier_valid
+ * 
+ * Verifies that a name can be used as a C identifier.
+ * 
+ * name: A null-terminated string to check.
+ * 
+ * returns: true upon success, false upon failure.
+ */
+bool is_identifier_valid(char* name) {
+	bool valid = *name != '\0' && !isdigit((unsigned char) *name);
+	while (*name != '\0' && valid) {
+		valid = isalnum((unsigned char) *name) || *name == '_';
+		name++;
+	}
+	return valid;
+}
+
+/*
+ * write_trie_source
+ * 
+ * Writes C source for a read-only copy of the trie and a function to look
+ * words up in it. The nodes are laid out breadth-first in a static const
+ * array, so the compiled dictionary lives in .rodata and needs no setup.
+ * 
+ * Each node is a pair of unsigned ints: a mask with bit c set if the node has
+ * a child for letter c and bit ENDS_WORD_BIT set if the node ends a word, and
+ * the index of its first child. A node's children are stored together in
+ * letter order.
+ * 
+ * head: The head of the trie to write out.
+ * out: The stream to write the source to.
+ * name: The prefix for the generated identifiers.
+ * 
+ * returns: 0 upon success, -1 upon a write error, -2 upon a bad name, or -3
+ * 			upon other failure.
+ */
+int write_trie_source(struct node* head, FILE* out, char* name) {
+	struct node** queue;
+	struct node* curr_node;
+	size_t num_nodes;
+	size_t next_child = 1; // The index the next node's children start at
+	unsigned int mask;
+	if (head == NULL || out == NULL || name == NULL || 
+			DICT_SIZE >= ENDS_WORD_BIT) {
+		return -3;
+	}
+	if (!is_identifier_valid(name)) {
+		return -2;
+	}
+	num_nodes = count_nodes(head);
+	queue = (struct node**) malloc(num_nodes * sizeof(struct node*));
+	if (queue == NULL) { // Catch error in malloc
+		return -3;
+	}
+	fprintf(out, "/*\n * Generated by write_trie_source(). Do not edit.\n"
+			" *\n * %d words, %zu nodes.\n *\n"
+			" * int %s_lookup(const char* word);\n */\n\n", 
+			head -> count, num_nodes, name);
+	fprintf(out, "static const unsigned int %s_nodes[%zu][2] = {\n", 
+			name, num_nodes);
+	queue[0] = head;
+	for (size_t i = 0; i < num_nodes; i++) {
+		curr_node = queue[i];
+		mask = curr_node -> ends_word ? 1U << ENDS_WORD_BIT : 0;
+		for (int j = 0; j < DICT_SIZE; j++) {
+			if (curr_node -> next[j] != NULL) {
+				mask |= 1U << j;
+			}
+		}
+		fprintf(out, "\t{0x%08xU, %zuU},\n", mask, next_child);
+		for (int j = 0; j < DICT_SIZE; j++) {
+			if (curr_node -> next[j] != NULL) {
+				queue[next_child] = curr_node -> next[j];
+				next_child++;
+			}
+		}
+	}
+	free(queue);
+	fprintf(out, "};\n\n"
+			"/*\n * Counts the set bits in a child mask.\n */\n"
+			"static unsigned int %s_popcount(unsigned int mask) {\n"
+			"\tmask = mask - ((mask >> 1) & 0x55555555U);\n"
+			"\tmask = (mask & 0x33333333U) + ((mask >> 2) & 0x33333333U);\n"
+			"\treturn (((mask + (mask >> 4)) & 0x0f0f0f0fU) * 0x01010101U)"
+			" >> 24;\n}\n\n", name);
+	fprintf(out, "/*\n * Returns 1 if word is in the dictionary, 0 otherwise."
+			"\n */\n"
+			"int %s_lookup(const char* word) {\n"
+			"\tunsigned int node = 0;\n"
+			"\tunsigned int bit;\n"
+			"\tfor (; *word != '\\0'; word++) {\n"
+			"\t\tif (*word - %d < 0 || *word - %d >= %d) {\n"
+			"\t\t\treturn 0;\n"
+			"\t\t}\n"
+			"\t\tbit = 1U << (*word - %d);\n"
+			"\t\tif ((%s_nodes[node][0] & bit) == 0) {\n"
+			"\t\t\treturn 0;\n"
+			"\t\t}\n"
+			"\t\tnode = %s_nodes[node][1] + "
+			"%s_popcount(%s_nodes[node][0] & (bit - 1));\n"
+			"\t}\n"
+			"\treturn %s_nodes[node][0] >> %d;\n"
+			"}\n", name, ASCII_OFFSET, ASCII_OFFSET, DICT_SIZE, ASCII_OFFSET,
+			name, name, name, name, name, ENDS_WORD_BIT);
+	return ferror(out) ? -1 : 0;
+}
+
+/*
+ * write_words_below
+ * 
+ * A helper function for write_trie_words. Recursively writes every word under
+ * a node, growing the word buffer as needed.
+ * 
+ * curr_node: The node to write the words under.
+ * out: The stream to write to.
+ * buffer: The word buffer, holding the characters leading to curr_node.
+ * buffer_len: The number of characters available in the word buffer.
+ * len: The number of characters leading to curr_node.
+ * 
+ * returns: 0 upon success, or -3 upon failure to grow the buffer.
+ */
+int write_words_below(struct node* curr_node, FILE* out, char** buffer, 
+						size_t* buffer_len, size_t len) {
+	char* new_buffer;
+	int ret = 0;
+	if (len + 2 > *buffer_len) {
+		new_buffer = (char*) realloc(*buffer, *buffer_len * 2);
+		if (new_buffer == NULL) { // Catch error in realloc
+			return -3;
+		}
+		*buffer = new_buffer;
+		*buffer_len *= 2;
+	}
+	if (curr_node -> ends_word && len > 0) {
+		(*buffer)[len] = '\n';
+		fwrite(*buffer, 1, len + 1, out);
+	}
+	for (int i = 0; i < DICT_SIZE && ret == 0; i++) {
+		if (curr_node -> next[i] != NULL) {
+			(*buffer)[len] = i + ASCII_OFFSET;
+			ret = write_words_below(curr_node -> next[i], out, buffer, 
+									buffer_len, len + 1);
+		}
+	}
+	return ret;
+}
+
+/*
+ * write_trie_words
+ * 
+ * Writes every non-empty word in the trie to a stream in sorted order, one per
+ * line, in the format load_trie() reads.
+ * 
+ * head: The head of the trie to write out.
+ * out: The stream to write to.
+ * 
+ * returns: 0 upon success, -1 upon a write error, or -3 upon other failure.
+ */
+int write_trie_words(struct node* head, FILE* out) {
+	size_t buffer_len = 64;
+	char* buffer;
+	int ret;
+	if (head == NULL || out == NULL) {
+		return -3;
+	}
+	buffer = (char*) malloc(buffer_len);
+	if (buffer == NULL) { // Catch error in malloc
+		return -3;
+	}
+	ret = write_words_below(head, out, &buffer, &buffer_len, 0);
+	free(buffer);
+	if (ret == 0 && ferror(out)) {
+		ret = -1;
 	}
 	return ret;
 }
@@ -34,6 +34,9 @@ SOFTWARE.
 #ifndef TRIE_H
 #define TRIE_H
 
+#include <stddef.h>
+#include <stdio.h>
+
 /*
  * trie 
  * 
@@ -41,6 +44,18 @@ SOFTWARE.
  */
 typedef struct node Trie;
 
+/*
+ * load_stats
+ * 
+ * Counters filled in by load_trie().
+ */
+struct load_stats {
+	size_t bytes_read; // Bytes read from the stream
+	size_t words_read; // Whitespace-separated tokens seen
+	size_t words_added; // Words that were not already in the trie
+	size_t words_rejected; // Tokens with non-letters or over 4096 letters
+};
+
 /*
  * add_to_trie
  * 
@@ -51,7 +66,8 @@ typedef struct node Trie;
  * 
  * returns: 1 if the word was added to the trie, 0 if the word was already in 
  * 			the trie, -1 upon failure due to the maximum size of the trie being 
- * 			exceeded, -2 upon bad words input, or -3 upon other failure.
+ * 			exceeded, -2 upon bad words input (including words longer than
+ * 			4096 letters), or -3 upon other failure.
  */
 int add_to_trie(Trie* trie, char* word);
 
@@ -71,7 +87,8 @@ int check_trie(Trie* trie, char* word);
 /*
  * clear_trie
  * 
- * Deletes all entries in the trie. Does not delete the head node.
+ * Deletes all entries in the trie, including nodes still waiting to be
+ * reclaimed. Does not delete the head node.
  * 
  * trie: The trie to clear.
  * 
@@ -79,6 +96,30 @@ int check_trie(Trie* trie, char* word);
  */
 int clear_trie(Trie* trie);
 
+/*
+ * compact_trie
+ * 
+ * Moves every node of the trie into new contiguous arenas, restoring the
+ * lookup speed lost after many adds and deletes scatter nodes across the
+ * heap. The top levels are laid out breadth-first and the subtrees below them
+ * depth-first.
+ * 
+ * An arena stays allocated until the last of its nodes is freed, and the
+ * slots of nodes freed before then are not reused, while new nodes are
+ * allocated outside the arenas. Under steady churn memory therefore grows
+ * towards the old arenas plus the new nodes, so compact_trie() must be rerun
+ * periodically: compacting again moves the surviving nodes out and frees the
+ * old arenas. Each run walks and copies every node, roughly 0.4 to 1
+ * microseconds per node, and briefly holds both copies of the nodes plus
+ * 8 bytes per node.
+ * 
+ * trie: The trie to compact.
+ * 
+ * returns: The number of nodes moved, or -3 upon failure to allocate, in
+ * 			which case the trie is unchanged.
+ */
+int compact_trie(Trie* trie);
+
 /*
  * create_trie
  * 
@@ -101,4 +142,251 @@ Trie* create_trie();
  */
 int delete_from_trie(Trie* trie, char* word);
 
+/*
+ * delete_prefix_from_trie
+ * 
+ * Deletes every word starting with a prefix from the trie in one descent. The
+ * detached nodes are reclaimed lazily, either by later calls to add_to_trie()
+ * or by reclaim_trie_nodes().
+ * 
+ * trie: The trie to delete entries from.
+ * prefix: The lowercase prefix of the words to delete. An empty prefix deletes
+ * 			every word.
+ * 
+ * returns: The number of words deleted from the trie, or -1 upon error.
+ */
+int delete_prefix_from_trie(Trie* trie, char* prefix);
+
+/*
+ * difference_tries
+ * 
+ * Removes every word in other from dest. Only paths present in both tries are
+ * visited, so the cost is proportional to their overlap.
+ * 
+ * dest: The trie to remove words from.
+ * other: The trie holding the words to remove. Left unchanged.
+ * 
+ * returns: The number of words left in dest, or -1 upon error (including dest
+ * 			and other being the same trie).
+ */
+int difference_tries(Trie* dest, Trie* other);
+
+/*
+ * disable_trie_filter
+ * 
+ * Removes the filter from a trie, freeing it. Must be called before freeing a
+ * trie that has a filter.
+ * 
+ * trie: The trie to remove the filter from.
+ * 
+ * returns: 0 upon success, -1 upon error.
+ */
+int disable_trie_filter(Trie* trie);
+
+/*
+ * enable_trie_filter
+ * 
+ * Gives a trie a counting Bloom filter that check_trie() consults before
+ * walking the trie, so most words not in the trie are rejected after reading
+ * a single cache line. Words in the trie pay for that extra cache line, so
+ * the filter only pays off when most lookups miss, most of all when the
+ * misses share long prefixes with words in the trie. The filter is kept up
+ * to date by add_to_trie(), delete_from_trie(), load_trie() and the set
+ * operations. Replaces any existing filter.
+ * 
+ * trie: The trie to filter.
+ * expected_words: The number of words the filter is sized for.
+ * 
+ * returns: 0 upon success, -1 upon error, or -3 upon failure to allocate.
+ */
+int enable_trie_filter(Trie* trie, size_t expected_words);
+
+/*
+ * intersect_tries
+ * 
+ * Removes every word from dest that is not also in other. Only paths present
+ * in both tries are visited, so the cost is proportional to their overlap.
+ * 
+ * dest: The trie to remove words from.
+ * other: The trie holding the words to keep. Left unchanged.
+ * 
+ * returns: The number of words left in dest, or -1 upon error (including dest
+ * 			and other being the same trie).
+ */
+int intersect_tries(Trie* dest, Trie* other);
+
+
+/*
+ * load_trie
+ * 
+ * Adds every whitespace-separated word in a stream to the trie. The stream is
+ * read in large blocks and words are inserted straight out of the read buffer.
+ * Uppercase letters are lowercased, and words with any other characters than
+ * letters, or with more than 4096 letters, are rejected.
+ * 
+ * trie: The trie to add the words to.
+ * stream: The stream to read words from.
+ * stats: Counters for the load, or NULL. Reset before loading.
+ * 
+ * returns: 0 upon success, -1 upon a read error, or -3 upon other failure.
+ */
+int load_trie(Trie* trie, FILE* stream, struct load_stats* stats);
+
+/*
+ * longest_prefix_in_trie
+ * 
+ * Finds the longest word in the trie that is a prefix of a buffer, using a
+ * single descent of the trie.
+ * 
+ * trie: The trie to check.
+ * text: The buffer to match against. Does not need to be null-terminated.
+ * len: The number of characters of text to consider.
+ * 
+ * returns: The length of the longest word in the trie that text starts with,
+ * 			0 if no non-empty word matches, or -1 upon an error.
+ */
+int longest_prefix_in_trie(Trie* trie, char* text, size_t len);
+
+/*
+ * reclaim_trie_nodes
+ * 
+ * Frees nodes left behind in a trie by delete_prefix_from_trie(),
+ * intersect_tries() and difference_tries(). clear_trie() also frees them.
+ * 
+ * trie: The trie whose detached nodes to free.
+ * max_nodes: The most nodes to free, or 0 or less to free all pending nodes.
+ * 
+ * returns: The number of nodes freed, or -1 upon error.
+ */
+int reclaim_trie_nodes(Trie* trie, int max_nodes);
+
+/*
+ * rank_in_trie
+ * 
+ * Counts the words in the trie that sort before a word in one descent. The
+ * word does not need to be in the trie.
+ * 
+ * trie: The trie to check.
+ * word: A string with the lowercase word (consisting only of [a-z]) to rank.
+ * 
+ * returns: The number of words in the trie that sort before word, or -2 upon
+ * 			bad word input.
+ */
+int rank_in_trie(Trie* trie, char* word);
+
+/*
+ * rebuild_trie_filter
+ * 
+ * Refills the filter of a trie from its words. Words removed by
+ * delete_prefix_from_trie(), intersect_tries() or difference_tries() stay
+ * counted in the filter, which only costs extra false positives; rebuilding
+ * clears them out.
+ * 
+ * trie: The trie whose filter to rebuild.
+ * 
+ * returns: 0 upon success, or -1 upon error (including having no filter).
+ */
+int rebuild_trie_filter(Trie* trie);
+
+/*
+ * segment_greedy_with_trie
+ * 
+ * Splits a buffer into words from the trie, repeatedly taking the longest
+ * word starting at the current position. Fast, but does not backtrack, so
+ * it can fail on text that segment_optimal_with_trie() can split.
+ * 
+ * trie: The trie holding the dictionary.
+ * text: The buffer to segment. Does not need to be null-terminated.
+ * len: The number of characters of text to segment.
+ * bounds: An array which receives the end offset of each word, in order.
+ * max_bounds: The number of entries available in bounds.
+ * 
+ * returns: The number of words text was split into, -1 if text could not be
+ * 			segmented, -2 if more than max_bounds words are needed, or -3 upon
+ * 			other failure.
+ */
+int segment_greedy_with_trie(Trie* trie, char* text, size_t len, 
+								size_t* bounds, size_t max_bounds);
+
+/*
+ * segment_optimal_with_trie
+ * 
+ * Splits a buffer into the fewest possible words from the trie.
+ * 
+ * trie: The trie holding the dictionary.
+ * text: The buffer to segment. Does not need to be null-terminated.
+ * len: The number of characters of text to segment.
+ * bounds: An array which receives the end offset of each word, in order.
+ * max_bounds: The number of entries available in bounds.
+ * 
+ * returns: The number of words text was split into, -1 if text could not be
+ * 			segmented, -2 if more than max_bounds words are needed, or -3 upon
+ * 			other failure.
+ */
+int segment_optimal_with_trie(Trie* trie, char* text, size_t len, 
+								size_t* bounds, size_t max_bounds);
+
+/*
+ * select_from_trie
+ * 
+ * Finds the word at a position in the trie's sorted order in one descent, so
+ * a dictionary can be paged through or sampled without iterating from the
+ * start.
+ * 
+ * trie: The trie to look in.
+ * n: The position of the word, counting from 0.
+ * buffer: Receives the null-terminated word.
+ * buffer_len: The number of characters available in buffer.
+ * 
+ * returns: The length of the word, -1 if n is not a position in the trie, or
+ * 			-2 if the word does not fit in buffer.
+ */
+int select_from_trie(Trie* trie, int n, char* buffer, size_t buffer_len);
+
+/*
+ * union_tries
+ * 
+ * Moves every word in src into dest, leaving src empty. Subtrees only src has
+ * are grafted onto dest whole, so the cost is proportional to the overlap of
+ * the two tries. If dest has a filter, the grafted words must also be added
+ * to it, which visits the grafted subtrees too.
+ * 
+ * dest: The trie to add words to.
+ * src: The trie to take words from. Emptied, but not freed.
+ * 
+ * returns: The number of words in dest, or -1 upon error (including dest and
+ * 			src being the same trie).
+ */
+int union_tries(Trie* dest, Trie* src);
+
+/*
+ * write_trie_source
+ * 
+ * Writes C source for a read-only copy of the trie and a function,
+ * int <name>_lookup(const char* word), that returns 1 if word is in it and 0
+ * otherwise. The dictionary is a static const array, so once compiled it
+ * lives in .rodata and needs no heap or startup time.
+ * 
+ * trie: The trie to write out.
+ * out: The stream to write the source to.
+ * name: The prefix for the generated identifiers. Must be a C identifier.
+ * 
+ * returns: 0 upon success, -1 upon a write error, -2 upon a bad name, or -3
+ * 			upon other failure.
+ */
+int write_trie_source(Trie* trie, FILE* out, char* name);
+
+/*
+ * write_trie_words
+ * 
+ * Writes every non-empty word in the trie to a stream in sorted order, one per
+ * line, in the format load_trie() reads.
+ * 
+ * trie: The trie to write out.
+ * out: The stream to write to.
+ * 
+ * returns: 0 upon success, -1 upon a write error, or -3 upon other failure.
+ */
+int write_trie_words(Trie* trie, FILE* out);
+
 #endif
@@ -0,0 +1,91 @@
+/*
+trie_gen.c
+
+Dani Sprague
+February 2021
+https://github.com/DaniSprague/C-Word-Trie
+
+Compiles a word list into C source for a static, read-only trie.
+
+Usage: trie_gen name [file] > name.c
+Reads from stdin if no file is given. The generated source defines
+int name_lookup(const char* word).
+
+
+MIT License
+
+Copyright (c) 2021 Dani Sprague
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "trie.h"
+
+/*
+ * main
+ * 
+ * Loads the words in a file or stdin into a trie and writes it out as C
+ * source to stdout.
+ * 
+ * returns: 0 upon success, 1 otherwise.
+ */
+int main(int argc, char** argv) {
+	struct load_stats stats;
+	FILE* stream = stdin;
+	Trie* trie;
+	int ret;
+	if (argc < 2 || argc > 3) {
+		fprintf(stderr, "Usage: %s name [file] > name.c\n", argv[0]);
+		return 1;
+	}
+	if (argc == 3) {
+		stream = fopen(argv[2], "rb");
+		if (stream == NULL) {
+			perror(argv[2]);
+			return 1;
+		}
+	}
+	trie = create_trie();
+	if (trie == NULL) {
+		fprintf(stderr, "Could not create trie.\n");
+		return 1;
+	}
+	ret = load_trie(trie, stream, &stats);
+	if (stream != stdin) {
+		fclose(stream);
+	}
+	if (ret != 0) {
+		fprintf(stderr, "Load failed with error %d.\n", ret);
+	} else {
+		if (stats.words_rejected > 0) {
+			fprintf(stderr, "Skipped %zu words with characters other than "
+					"letters.\n", stats.words_rejected);
+		}
+		ret = write_trie_source(trie, stdout, argv[1]);
+		if (ret != 0) {
+			fprintf(stderr, "Writing source failed with error %d.\n", ret);
+		}
+	}
+	clear_trie(trie);
+	free(trie);
+	return ret == 0 ? 0 : 1;
+}
@@ -0,0 +1,94 @@
+/*
+trie_load.c
+
+Dani Sprague
+February 2021
+https://github.com/DaniSprague/C-Word-Trie
+
+Loads a word list into a trie, reporting load throughput.
+
+Usage: trie_load [file]
+Reads from stdin if no file is given.
+
+
+MIT License
+
+Copyright (c) 2021 Dani Sprague
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "trie.h"
+
+/*
+ * main
+ * 
+ * Loads the words in a file or stdin into a trie and prints load statistics.
+ * 
+ * returns: 0 upon success, 1 otherwise.
+ */
+int main(int argc, char** argv) {
+	struct load_stats stats;
+	struct timespec start;
+	struct timespec end;
+	double seconds;
+	FILE* stream = stdin;
+	Trie* trie;
+	int ret;
+	if (argc > 2) {
+		fprintf(stderr, "Usage: %s [file]\n", argv[0]);
+		return 1;
+	}
+	if (argc == 2) {
+		stream = fopen(argv[1], "rb");
+		if (stream == NULL) {
+			perror(argv[1]);
+			return 1;
+		}
+	}
+	trie = create_trie();
+	if (trie == NULL) {
+		fprintf(stderr, "Could not create trie.\n");
+		return 1;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	ret = load_trie(trie, stream, &stats);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	if (stream != stdin) {
+		fclose(stream);
+	}
+	if (ret != 0) {
+		fprintf(stderr, "Load failed with error %d.\n", ret);
+	}
+	seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	if (seconds <= 0) {
+		seconds = 1e-9;
+	}
+	printf("Read %zu bytes, %zu words (%zu added, %zu rejected) in %.3f s\n",
+			stats.bytes_read, stats.words_read, stats.words_added, 
+			stats.words_rejected, seconds);
+	printf("%.0f words/sec, %.2f MB/sec\n", stats.words_read / seconds,
+			stats.bytes_read / seconds / 1e6);
+	clear_trie(trie);
+	free(trie);
+	return ret == 0 ? 0 : 1;
+}
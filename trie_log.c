@@ -0,0 +1,620 @@
+/*
+trie_log.c
+
+Dani Sprague
+February 2021
+https://github.com/DaniSprague/C-Word-Trie
+
+A change log and checkpoints for a trie, so a trie that changes over time
+can be recovered after a restart without re-adding every word it ever held.
+
+The log is a text file with one change per line: '+' or '-' followed by the
+word. A checkpoint is every word in the trie, one per line, as written by
+write_trie_words(). Recovery loads the latest checkpoint with load_trie() and
+replays the log written since.
+
+MIT License
+
+Copyright (c) 2021 Dani Sprague
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _POSIX_C_SOURCE 200809L // For fsync, ftruncate and getline
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "trie.h"
+#include "trie_log.h"
+
+#define LETTERS "abcdefghijklmnopqrstuvwxyz" // The characters words may hold
+
+/*
+ * trie_log
+ * 
+ * The struct for a change log kept for a trie.
+ */
+struct trie_log {
+	Trie* trie;
+	int fd; // The log, opened for appending, or -1 once it can't be used
+	off_t length; // The length of the log
+	off_t synced_length; // The length of the log at the last sync
+	char* group; // The changes written since the last sync
+	size_t group_len;
+	size_t group_cap;
+	char* log_path;
+	char* checkpoint_path;
+	char* temp_path;
+	int group_size;
+	int checkpoint_every;
+	int unsynced; // Changes written since the last sync
+	int uncheckpointed; // Changes written since the last checkpoint
+};
+
+/*
+ * The function the log uses to sync files to disk.
+ */
+int (*trie_log_fsync)(int fd) = &fsync;
+
+/*
+ * make_path
+ * 
+ * Builds the path of one of the log's files.
+ * 
+ * path: The path the log files are named after.
+ * suffix: The suffix for the file.
+ * 
+ * returns: A newly allocated path, or NULL upon error.
+ */
+static char* make_path(char* path, char* suffix) {
+	char* full_path = (char*) malloc(strlen(path) + strlen(suffix) + 1);
+	if (full_path != NULL) {
+		strcpy(full_path, path);
+		strcat(full_path, suffix);
+	}
+	return full_path;
+}
+
+/*
+ * sync_directory
+ * 
+ * Syncs the directory holding a file, so a rename into it is durable.
+ * 
+ * path: The path of the file.
+ * 
+ * returns: 0 upon success, -1 upon error.
+ */
+static int sync_directory(char* path) {
+	char* dir_path = make_path(path, "");
+	char* slash;
+	int fd;
+	int ret = -1;
+	if (dir_path == NULL) {
+		return -1;
+	}
+	slash = strrchr(dir_path, '/');
+	if (slash == NULL) {
+		strcpy(dir_path, ".");
+	} else if (slash == dir_path) {
+		dir_path[1] = '\0';
+	} else {
+		*slash = '\0';
+	}
+	fd = open(dir_path, O_RDONLY);
+	if (fd >= 0) {
+		ret = trie_log_fsync(fd) == 0 ? 0 : -1;
+		close(fd);
+	}
+	free(dir_path);
+	return ret;
+}
+
+/*
+ * sync_file
+ * 
+ * Flushes a stream and syncs it to disk.
+ * 
+ * file: The stream to sync.
+ * 
+ * returns: 0 upon success, -1 upon error.
+ */
+static int sync_file(FILE* file) {
+	if (fflush(file) != 0 || trie_log_fsync(fileno(file)) != 0) {
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * open_log_file
+ * 
+ * Opens the log file for appending, creating it if it does not exist. A new
+ * file's directory is synced, so the file survives a crash along with the
+ * changes synced to it.
+ * 
+ * log: The log whose file to open.
+ * 
+ * returns: 0 upon success, -1 upon error.
+ */
+static int open_log_file(TrieLog* log) {
+	log -> fd = open(log -> log_path, O_WRONLY | O_APPEND);
+	if (log -> fd < 0 && errno == ENOENT) {
+		log -> fd = open(log -> log_path, O_WRONLY | O_APPEND | O_CREAT | 
+							O_EXCL, 0644);
+		if (log -> fd >= 0 && sync_directory(log -> log_path) != 0) {
+			close(log -> fd);
+			log -> fd = -1;
+		}
+	}
+	if (log -> fd < 0) {
+		return -1;
+	}
+	log -> length = lseek(log -> fd, 0, SEEK_END);
+	log -> synced_length = log -> length;
+	return log -> length < 0 ? -1 : 0;
+}
+
+/*
+ * replace_file
+ * 
+ * Atomically replaces a file with a synced copy of new contents, by writing
+ * them to a temporary file and renaming it into place.
+ * 
+ * log: The log whose temporary path to use.
+ * path: The path of the file to replace.
+ * trie: The trie to write out as a checkpoint, or NULL to write a log holding
+ * 			only whether the trie contains the empty word.
+ * 
+ * returns: 0 upon success, -1 upon a write error, or -3 upon other failure.
+ */
+static int replace_file(TrieLog* log, char* path, Trie* trie) {
+	FILE* file = fopen(log -> temp_path, "wb");
+	int ret = 0;
+	if (file == NULL) {
+		return -1;
+	}
+	if (trie != NULL) {
+		ret = write_trie_words(trie, file);
+	} else if (check_trie(log -> trie, "") == 1) { // Checkpoints can't hold it
+		fputs("+\n", file);
+	}
+	if (ret == 0 && sync_file(file) != 0) {
+		ret = -1;
+	}
+	if (fclose(file) != 0 && ret == 0) {
+		ret = -1;
+	}
+	if (ret == 0 && rename(log -> temp_path, path) != 0) {
+		ret = -1;
+	}
+	if (ret == 0) {
+		ret = sync_directory(path);
+	} else {
+		remove(log -> temp_path);
+	}
+	return ret;
+}
+
+/*
+ * replay_log
+ * 
+ * Applies the changes in the log file to the trie. A last line with no
+ * newline is a change cut off by a crash mid-write, and is cut from the log
+ * so new changes follow the last whole change cleanly. Any other bad line
+ * means the log is damaged, and replay fails.
+ * 
+ * log: The log to replay.
+ * 
+ * returns: 0 upon success, -1 upon a read error, -2 upon a bad line before the
+ * 			end of the log, or -3 upon other failure.
+ */
+static int replay_log(TrieLog* log) {
+	FILE* file = fopen(log -> log_path, "rb");
+	char* line = NULL;
+	size_t line_len = 0;
+	ssize_t read_len;
+	long good_len = 0; // The length of the log up to the last whole change
+	bool torn = false;
+	int ret = 0;
+	if (file == NULL) { // No log yet
+		return 0;
+	}
+	while (ret == 0 && (read_len = getline(&line, &line_len, file)) > 0) {
+		if (line[read_len - 1] != '\n') { // Only the last line can lack one
+			torn = true;
+			break;
+		}
+		line[read_len - 1] = '\0';
+		if (line[0] == '+') {
+			ret = add_to_trie(log -> trie, line + 1);
+		} else if (line[0] == '-' && 
+					(ssize_t) strspn(line + 1, LETTERS) == read_len - 2) {
+			ret = delete_from_trie(log -> trie, line + 1);
+		} else {
+			ret = -2;
+		}
+		if (ret >= 0) {
+			ret = 0;
+			good_len += read_len;
+		}
+	}
+	if (ret == 0 && ferror(file)) {
+		ret = -1;
+	}
+	if (ret == 0 && torn && truncate(log -> log_path, good_len) != 0) {
+		ret = -1;
+	}
+	free(line);
+	fclose(file);
+	return ret < -2 ? -3 : ret;
+}
+
+/*
+ * fail_log
+ * 
+ * Stops the log from taking more changes, after its file could not be cut
+ * back to match the trie.
+ * 
+ * log: The log to stop.
+ * 
+ * returns: -4
+ */
+static int fail_log(TrieLog* log) {
+	close(log -> fd);
+	log -> fd = -1;
+	return -4;
+}
+
+/*
+ * undo_change
+ * 
+ * Reverts a change in the trie.
+ * 
+ * log: The log of the trie to revert the change in.
+ * op: '+' for an add or '-' for a delete.
+ * word: The word changed.
+ * 
+ * returns: none
+ */
+static void undo_change(TrieLog* log, char op, char* word) {
+	if (op == '+') {
+		delete_from_trie(log -> trie, word);
+	} else {
+		add_to_trie(log -> trie, word);
+	}
+}
+
+/*
+ * roll_back_group
+ * 
+ * Cuts every change written since the last sync back out of the log and
+ * undoes them in the trie, newest first. Used when a sync fails, as the
+ * changes may then be lost from the file even though they were written.
+ * 
+ * log: The log to roll back.
+ * 
+ * returns: -1 if the changes were rolled back, or -4 if the log could not be
+ * 			cut back, in which case the trie keeps them.
+ */
+static int roll_back_group(TrieLog* log) {
+	char* record;
+	if (ftruncate(log -> fd, log -> synced_length) != 0 || 
+			trie_log_fsync(log -> fd) != 0) {
+		return fail_log(log);
+	}
+	while (log -> group_len > 0) {
+		log -> group[log -> group_len - 1] = '\0';
+		record = log -> group + log -> group_len - 1;
+		while (record > log -> group && record[-1] != '\n') {
+			record--;
+		}
+		undo_change(log, record[0], record + 1);
+		log -> group_len = record - log -> group;
+	}
+	log -> length = log -> synced_length;
+	log -> uncheckpointed -= log -> unsynced;
+	log -> unsynced = 0;
+	return -1;
+}
+
+/*
+ * write_change
+ * 
+ * Appends a change to the log, syncing if the group is full. A change that
+ * cannot be written is cut back out of the log and undone in the trie, and a
+ * failed sync rolls back the whole group.
+ * 
+ * log: The log to append to.
+ * op: '+' for an add or '-' for a delete.
+ * word: The word changed.
+ * 
+ * returns: 0 upon success, -1 if the change was undone, -3 upon failure to
+ * 			allocate, in which case the change was also undone, or -4 if the
+ * 			log could not be cut back.
+ */
+static int write_change(TrieLog* log, char op, char* word) {
+	size_t len = strlen(word) + 2;
+	char* record;
+	size_t new_cap;
+	ssize_t written;
+	if (log -> group_len + len > log -> group_cap) {
+		new_cap = log -> group_cap == 0 ? 256 : log -> group_cap * 2;
+		while (new_cap < log -> group_len + len) {
+			new_cap *= 2;
+		}
+		record = (char*) realloc(log -> group, new_cap);
+		if (record == NULL) { // Catch error in realloc
+			undo_change(log, op, word);
+			return -3;
+		}
+		log -> group = record;
+		log -> group_cap = new_cap;
+	}
+	record = log -> group + log -> group_len;
+	record[0] = op;
+	memcpy(record + 1, word, len - 2);
+	record[len - 1] = '\n';
+	written = write(log -> fd, record, len); // One write, so no stdio buffer
+	if (written != (ssize_t) len) {
+		if (ftruncate(log -> fd, log -> length) != 0) {
+			return fail_log(log);
+		}
+		undo_change(log, op, word);
+		return -1;
+	}
+	log -> group_len += len;
+	log -> length += len;
+	log -> unsynced++;
+	log -> uncheckpointed++;
+	if (log -> group_size > 0 && log -> unsynced >= log -> group_size) {
+		return sync_trie_log(log);
+	}
+	return 0;
+}
+
+/*
+ * checkpoint_trie_log
+ * 
+ * Syncs the log, then writes every word in the trie to a new checkpoint and
+ * empties the log. Recovery only has to replay changes made after the latest
+ * checkpoint. If the sync fails, the changes since the last sync are rolled
+ * back as by sync_trie_log() and no checkpoint is taken.
+ * 
+ * log: The log to checkpoint.
+ * 
+ * returns: 0 upon success, -1 upon a write error, or -3 upon other failure.
+ */
+int checkpoint_trie_log(TrieLog* log) {
+	int ret;
+	if (log == NULL) {
+		return -3;
+	}
+	// With the log synced, a crash before it is replaced just replays it over
+	// the new checkpoint, which gives the same trie.
+	ret = sync_trie_log(log) == 0 ? 0 : -1;
+	if (ret == 0) {
+		ret = replace_file(log, log -> checkpoint_path, log -> trie);
+	}
+	if (ret == 0) {
+		close(log -> fd);
+		ret = replace_file(log, log -> log_path, NULL);
+		if (open_log_file(log) != 0) {
+			ret = -1;
+		}
+	}
+	if (ret == 0) {
+		log -> unsynced = 0;
+		log -> uncheckpointed = 0;
+	}
+	return ret;
+}
+
+/*
+ * close_trie_log
+ * 
+ * Syncs and closes the log. Does not free the trie. If the sync fails, the
+ * changes since the last sync are rolled back as by sync_trie_log().
+ * 
+ * log: The log to close.
+ * 
+ * returns: 0 upon success, -1 upon a write error.
+ */
+int close_trie_log(TrieLog* log) {
+	int ret = 0;
+	if (log == NULL) {
+		return -1;
+	}
+	if (log -> fd >= 0) {
+		ret = sync_trie_log(log) == 0 ? 0 : -1;
+	}
+	if (log -> fd >= 0 && close(log -> fd) != 0) {
+		ret = -1;
+	}
+	free(log -> group);
+	free(log -> log_path);
+	free(log -> checkpoint_path);
+	free(log -> temp_path);
+	free(log);
+	return ret;
+}
+
+/*
+ * log_add_to_trie
+ * 
+ * Adds a word to the trie, then logs the change if the word is new. If the
+ * change cannot be written, it is cut back out of the log and undone. If a
+ * sync fails, every change since the last sync is rolled back as by
+ * sync_trie_log(). Either way the trie and recovery agree.
+ * 
+ * log: The log of the trie to add the word to.
+ * word: A string with the lowercase word to add (consisting only of [a-z]).
+ * 
+ * returns: 1 if the word was added to the trie, 0 if the word was already in 
+ * 			the trie, -1 upon a write error, -2 upon bad words input, -3 upon 
+ * 			other failure, or -4 upon a write error after which the log could
+ * 			not be cut back, in which case the word stays added and the log
+ * 			takes no more changes.
+ */
+int log_add_to_trie(TrieLog* log, char* word) {
+	int ret;
+	int written;
+	if (log == NULL || log -> fd < 0) {
+		return -3;
+	}
+	ret = add_to_trie(log -> trie, word);
+	if (ret == 1) {
+		written = write_change(log, '+', word);
+		ret = written == 0 ? 1 : written;
+	}
+	if (ret == 1 && log -> checkpoint_every > 0 && 
+			log -> uncheckpointed >= log -> checkpoint_every) {
+		written = sync_trie_log(log);
+		if (written != 0) {
+			return written;
+		}
+		checkpoint_trie_log(log); // The change is already safe in the log
+	}
+	return ret;
+}
+
+/*
+ * log_delete_from_trie
+ * 
+ * Deletes a word from the trie, then logs the change if the word was in the
+ * trie. Failures are handled as by log_add_to_trie().
+ * 
+ * log: The log of the trie to delete the word from.
+ * word: The lowercase string to delete from the trie.
+ * 
+ * returns: 1 if the word was deleted from the trie, 0 if the word was not in 
+ * 			the trie, -1 upon error, or -4 upon a write error after which the
+ * 			log could not be cut back, in which case the word stays deleted
+ * 			and the log takes no more changes.
+ */
+int log_delete_from_trie(TrieLog* log, char* word) {
+	int ret;
+	int written;
+	if (log == NULL || log -> fd < 0) {
+		return -1;
+	}
+	ret = delete_from_trie(log -> trie, word);
+	if (ret == 1) {
+		written = write_change(log, '-', word);
+		ret = written == 0 ? 1 : written == -4 ? -4 : -1;
+	}
+	if (ret == 1 && log -> checkpoint_every > 0 && 
+			log -> uncheckpointed >= log -> checkpoint_every) {
+		written = sync_trie_log(log);
+		if (written != 0) {
+			return written;
+		}
+		checkpoint_trie_log(log);
+	}
+	return ret;
+}
+
+/*
+ * open_trie_log
+ * 
+ * Recovers a trie from its latest checkpoint and the log written since, then
+ * opens the log for more changes.
+ * 
+ * trie: An empty trie to recover into.
+ * path: The path the log files are named after.
+ * group_size: The number of changes per sync, or 0 or less to only sync on
+ * 			request.
+ * checkpoint_every: The number of changes per checkpoint, or 0 or less to only
+ * 			checkpoint on request.
+ * 
+ * returns: A pointer to the log, or NULL upon error.
+ */
+TrieLog* open_trie_log(Trie* trie, char* path, int group_size, 
+						int checkpoint_every) {
+	TrieLog* log;
+	FILE* checkpoint;
+	int ret = 0;
+	if (trie == NULL || path == NULL) {
+		return NULL;
+	}
+	log = (TrieLog*) calloc(1, sizeof(TrieLog));
+	if (log == NULL) { // Catch error in calloc
+		return NULL;
+	}
+	log -> trie = trie;
+	log -> fd = -1;
+	log -> group_size = group_size;
+	log -> checkpoint_every = checkpoint_every;
+	log -> log_path = make_path(path, ".log");
+	log -> checkpoint_path = make_path(path, ".ckpt");
+	log -> temp_path = make_path(path, ".tmp");
+	if (log -> log_path == NULL || log -> checkpoint_path == NULL || 
+			log -> temp_path == NULL) {
+		ret = -3;
+	}
+	if (ret == 0) {
+		checkpoint = fopen(log -> checkpoint_path, "rb");
+		if (checkpoint != NULL) {
+			ret = load_trie(trie, checkpoint, NULL);
+			fclose(checkpoint);
+		}
+	}
+	if (ret == 0) {
+		ret = replay_log(log);
+	}
+	if (ret == 0) {
+		ret = open_log_file(log);
+	}
+	if (ret != 0) {
+		close_trie_log(log);
+		log = NULL;
+	}
+	return log;
+}
+
+/*
+ * sync_trie_log
+ * 
+ * Forces all logged changes to disk. If the sync fails, the changes written
+ * since the last sync may be lost from the file, so they are cut back out of
+ * the log and undone in the trie, newest first. If the log cannot be cut
+ * back, the trie keeps them and the log takes no more changes; close it and
+ * recover the trie with open_trie_log().
+ * 
+ * log: The log to sync.
+ * 
+ * returns: 0 upon success, -1 upon a write error, or -4 upon a write error
+ * 			after which the log could not be cut back.
+ */
+int sync_trie_log(TrieLog* log) {
+	if (log == NULL || log -> fd < 0) {
+		return -1;
+	}
+	if (trie_log_fsync(log -> fd) != 0) {
+		return roll_back_group(log);
+	}
+	log -> synced_length = log -> length;
+	log -> group_len = 0;
+	log -> unsynced = 0;
+	return 0;
+}
@@ -0,0 +1,158 @@
+/*
+trie_log.h
+
+Dani Sprague
+February 2021
+https://github.com/DaniSprague/C-Word-Trie
+
+A header for the change log that makes a trie durable.
+
+
+MIT License
+
+Copyright (c) 2021 Dani Sprague
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef TRIE_LOG_H
+#define TRIE_LOG_H
+
+#include "trie.h"
+
+/*
+ * trie_log
+ * 
+ * The struct for a change log kept for a trie.
+ */
+typedef struct trie_log TrieLog;
+
+/*
+ * trie_log_fsync
+ * 
+ * The function the log uses to sync files to disk, fsync() by default. Tests
+ * point it at a stand-in to make syncs fail.
+ */
+extern int (*trie_log_fsync)(int fd);
+
+/*
+ * checkpoint_trie_log
+ * 
+ * Syncs the log, then writes every word in the trie to a new checkpoint and
+ * empties the log. Recovery only has to replay changes made after the latest
+ * checkpoint. If the sync fails, the changes since the last sync are rolled
+ * back as by sync_trie_log() and no checkpoint is taken.
+ * 
+ * log: The log to checkpoint.
+ * 
+ * returns: 0 upon success, -1 upon a write error, or -3 upon other failure.
+ */
+int checkpoint_trie_log(TrieLog* log);
+
+/*
+ * close_trie_log
+ * 
+ * Syncs and closes the log. Does not free the trie. If the sync fails, the
+ * changes since the last sync are rolled back as by sync_trie_log().
+ * 
+ * log: The log to close.
+ * 
+ * returns: 0 upon success, -1 upon a write error.
+ */
+int close_trie_log(TrieLog* log);
+
+/*
+ * log_add_to_trie
+ * 
+ * Adds a word to the trie, then logs the change if the word is new. If the
+ * change cannot be written, it is cut back out of the log and undone. If a
+ * sync fails, every change since the last sync is rolled back as by
+ * sync_trie_log(). Either way the trie and recovery agree.
+ * 
+ * log: The log of the trie to add the word to.
+ * word: A string with the lowercase word to add (consisting only of [a-z]).
+ * 
+ * returns: 1 if the word was added to the trie, 0 if the word was already in 
+ * 			the trie, -1 upon a write error, -2 upon bad words input, -3 upon 
+ * 			other failure, or -4 upon a write error after which the log could
+ * 			not be cut back, in which case the word stays added and the log
+ * 			takes no more changes.
+ */
+int log_add_to_trie(TrieLog* log, char* word);
+
+/*
+ * log_delete_from_trie
+ * 
+ * Deletes a word from the trie, then logs the change if the word was in the
+ * trie. Failures are handled as by log_add_to_trie().
+ * 
+ * log: The log of the trie to delete the word from.
+ * word: The lowercase string to delete from the trie.
+ * 
+ * returns: 1 if the word was deleted from the trie, 0 if the word was not in 
+ * 			the trie, -1 upon error, or -4 upon a write error after which the
+ * 			log could not be cut back, in which case the word stays deleted
+ * 			and the log takes no more changes.
+ */
+int log_delete_from_trie(TrieLog* log, char* word);
+
+/*
+ * open_trie_log
+ * 
+ * Recovers a trie from its latest checkpoint and the log written since, then
+ * opens the log for more changes. The files used are path.ckpt and path.log,
+ * which are created if they do not exist.
+ * 
+ * Each change is applied to the trie, then appended to the log, and undone
+ * if it cannot be logged. The log is synced to disk once every group_size
+ * changes (a group commit), so a crash loses at most the last
+ * group_size - 1 changes. A failed sync rolls back the whole group, so the
+ * trie still matches what recovery would give. A checkpoint is taken automatically every
+ * checkpoint_every changes. Recovery cuts off a change torn by a crash
+ * mid-write, but fails on any other damage to the log.
+ * 
+ * trie: An empty trie to recover into.
+ * path: The path the log files are named after.
+ * group_size: The number of changes per sync, or 0 or less to only sync on
+ * 			sync_trie_log(), checkpoint_trie_log() and close_trie_log().
+ * checkpoint_every: The number of changes per checkpoint, or 0 or less to only
+ * 			checkpoint on checkpoint_trie_log().
+ * 
+ * returns: A pointer to the log, or NULL upon error or a damaged log.
+ */
+TrieLog* open_trie_log(Trie* trie, char* path, int group_size, 
+						int checkpoint_every);
+
+/*
+ * sync_trie_log
+ * 
+ * Forces all logged changes to disk. If the sync fails, the changes written
+ * since the last sync may be lost from the file, so they are cut back out of
+ * the log and undone in the trie, newest first. If the log cannot be cut
+ * back, the trie keeps them and the log takes no more changes; close it and
+ * recover the trie with open_trie_log().
+ * 
+ * log: The log to sync.
+ * 
+ * returns: 0 upon success, -1 upon a write error, or -4 upon a write error
+ * 			after which the log could not be cut back.
+ */
+int sync_trie_log(TrieLog* log);
+
+#endif